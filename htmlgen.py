@@ -3,6 +3,8 @@ with open("src/index.html", "r", encoding="utf-8") as f:
 
 with open("obj/audio-processor.js", "r", encoding="utf-8") as f:
     content = content.replace("___AUDIO_PROCESSOR___", f.read())
+with open("obj/engine-worker.js", "r", encoding="utf-8") as f:
+    content = content.replace("___ENGINE_WORKER___", f.read())
 with open("obj/color.vert", "r", encoding="utf-8") as f:
     content = content.replace("___COLOR_VERT___", f.read())
 with open("obj/color.frag", "r", encoding="utf-8") as f:
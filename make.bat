@@ -10,6 +10,7 @@ copy asset\favicon.svg bin
 copy asset\github.svg bin
 
 minify -o obj\audio-processor.js src\audio-processor.js
+minify -o obj\engine-worker.js src\engine-worker.js
 
 shader_minifier --format text --preserve-externals -o obj\color.vert .\src\shaders\color.vert
 shader_minifier --format text --preserve-externals -o obj\color.frag .\src\shaders\color.frag
@@ -22,7 +23,20 @@ copy obj\index.html bin\index.dev.html
 
 python fontgen.py
 
-set CFLAGS=-std=c23 -Os --target=wasm32 -nostdlib -DPLATFORM_WEB
+set CFLAGS=-std=c23 -Os --target=wasm32 -msimd128 -nostdlib -DPLATFORM_WEB
+set LDFLAGS=
+
+rem Block size, 64/128/256/512 (default 512). 128 renders one block per worklet
+rem callback: "set TR_BLOCK_SIZE=128" before running make.bat.
+if not "%TR_BLOCK_SIZE%"=="" set CFLAGS=%CFLAGS% -DTR_SAMPLE_COUNT=%TR_BLOCK_SIZE%
+
+rem "make.bat threads" builds with wasm atomics and a shared memory, the audio
+rem is then rendered in a worker (src/engine-worker.js) instead of the main thread.
+rem Memory size must match index.html.
+if "%1"=="threads" (
+    set CFLAGS=%CFLAGS% -matomics -mbulk-memory -DTR_WASM_THREADS
+    set LDFLAGS=--shared-memory --import-memory --initial-memory=134217728 --max-memory=134217728 --export=__stack_pointer --export=tr_engine_stack_top --export=tr_engine_run
+)
 
 clang %CFLAGS% -o obj/main.o -c src/main.c
 clang %CFLAGS% -o obj/modules.o -c src/modules.c
@@ -33,11 +47,13 @@ clang %CFLAGS% -o obj/platform_web.o -c src/platform_web.c
 clang %CFLAGS% -o obj/parser.o -c src/parser.c
 clang %CFLAGS% -o obj/timer.o -c src/timer.c
 clang %CFLAGS% -o obj/math.o -c src/math.c
+clang %CFLAGS% -o obj/cmdqueue.o -c src/cmdqueue.c
 
-wasm-ld @exports.txt -o bin/rack.wasm ^
+wasm-ld @exports.txt %LDFLAGS% -o bin/rack.wasm ^
     obj/main.o obj/modules.o obj/renderbuf.o ^
     obj/stdlib.o obj/strbuf.o obj/platform_web.o ^
-    obj/parser.o obj/timer.o obj/math.o
+    obj/parser.o obj/timer.o obj/math.o ^
+    obj/cmdqueue.o
 
 wasm-strip bin/rack.wasm
 
@@ -0,0 +1,192 @@
+// Error and speed of the math.c tiers, against the double precision libm.
+// Native tool, not part of the wasm build:
+//
+//   clang -O2 -o mathbench.exe mathbench/mathbench.c
+//
+// For each function and tier it prints the max error in ulp and absolute,
+// and the cost per sample of the _buf-style loop. The sine rows also report
+// the loudest harmonic of one cycle, relative to the fundamental.
+
+#include "../src/math.c"
+
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_ERROR_SAMPLES (1 << 20)
+#define BENCH_SPEED_SAMPLES (4096)
+#define BENCH_SPEED_REPEAT  (2000)
+#define BENCH_DFT_SIZE      (4096)
+#define BENCH_HARMONICS     (64)
+
+typedef float (*bench_fn)(float);
+typedef void (*bench_buf_fn)(float*, const float*, size_t);
+typedef double (*bench_ref_fn)(double);
+
+typedef struct bench_func
+{
+    const char* name;
+    float min;
+    float max;
+    bench_ref_fn ref;
+    bench_fn tiers[3];
+    bench_buf_fn bufs[3];
+} bench_func_t;
+
+// Same loop as the _buf functions in math.c, for each tier
+#define BENCH_BUF(_Name) \
+    static void _Name##_bench_buf(float* out, const float* in, size_t n) \
+    { \
+        for (size_t i = 0; i < n; ++i) out[i] = _Name##_kernel(in[i]); \
+    }
+
+#define BENCH_TIERS(_Name) \
+    BENCH_BUF(_Name##_fast) \
+    BENCH_BUF(_Name##_medium) \
+    BENCH_BUF(_Name##_precise)
+
+BENCH_TIERS(tr_sinf)
+BENCH_TIERS(tr_cosf)
+BENCH_TIERS(tr_tanf)
+BENCH_TIERS(tr_expf)
+BENCH_TIERS(tr_exp2f)
+BENCH_TIERS(tr_logf)
+
+#define BENCH_FUNC(_Name) \
+    { _Name##_fast, _Name##_medium, _Name##_precise }, \
+    { _Name##_fast_bench_buf, _Name##_medium_bench_buf, _Name##_precise_bench_buf }
+
+static double ref_sin(double x) { return __builtin_sin(x); }
+static double ref_cos(double x) { return __builtin_cos(x); }
+static double ref_tan(double x) { return __builtin_tan(x); }
+static double ref_exp(double x) { return __builtin_exp(x); }
+static double ref_exp2(double x) { return __builtin_exp2(x); }
+static double ref_log(double x) { return __builtin_log(x); }
+
+// Ranges cover what the modules feed in: oscillator phases, the lp cutoff
+// warp (tan up to 0.495π), control_to_hz and the 1V/oct inputs.
+static const bench_func_t g_funcs[] =
+{
+    { "sin",  -6.2831853f, 6.2831853f, ref_sin,  BENCH_FUNC(tr_sinf) },
+    { "cos",  -6.2831853f, 6.2831853f, ref_cos,  BENCH_FUNC(tr_cosf) },
+    { "tan",  -1.5550883f, 1.5550883f, ref_tan,  BENCH_FUNC(tr_tanf) },
+    { "exp",  -10.0f,      10.0f,      ref_exp,  BENCH_FUNC(tr_expf) },
+    { "exp2", -10.0f,      10.0f,      ref_exp2, BENCH_FUNC(tr_exp2f) },
+    { "log",  1e-3f,       1e5f,       ref_log,  BENCH_FUNC(tr_logf) },
+};
+
+static const char* g_tier_names[] = { "fast", "medium", "precise" };
+
+static float g_input[BENCH_SPEED_SAMPLES];
+static float g_output[BENCH_SPEED_SAMPLES];
+
+// Distance between |x| and the next float
+static double bench_ulp(float x)
+{
+    tr_float_bits_t v = { tr_fabsf(x) };
+    tr_float_bits_t next = { .u = v.u + 1 };
+    return (double)next.f - (double)v.f;
+}
+
+static double bench_now_ns(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void bench_error(const bench_func_t* func, bench_fn fn, double* max_ulp, double* max_abs)
+{
+    *max_ulp = 0.0;
+    *max_abs = 0.0;
+
+    for (int i = 0; i < BENCH_ERROR_SAMPLES; ++i)
+    {
+        const float x = func->min + (func->max - func->min) * ((float)i / (BENCH_ERROR_SAMPLES - 1));
+        const double ref = func->ref((double)x);
+        const double err = __builtin_fabs((double)fn(x) - ref);
+
+        const double ulp = bench_ulp((float)ref);
+        if (ulp > 0.0 && err / ulp > *max_ulp) *max_ulp = err / ulp;
+        if (err > *max_abs) *max_abs = err;
+    }
+}
+
+static double bench_speed(const bench_func_t* func, bench_buf_fn fn)
+{
+    for (int i = 0; i < BENCH_SPEED_SAMPLES; ++i)
+    {
+        g_input[i] = func->min + (func->max - func->min) * ((float)i / BENCH_SPEED_SAMPLES);
+    }
+
+    const double start = bench_now_ns();
+
+    for (int r = 0; r < BENCH_SPEED_REPEAT; ++r)
+    {
+        fn(g_output, g_input, BENCH_SPEED_SAMPLES);
+
+        // keep the loop from being hoisted out
+        __asm__ volatile("" : : "r"(g_output) : "memory");
+    }
+
+    return (bench_now_ns() - start) / ((double)BENCH_SPEED_SAMPLES * BENCH_SPEED_REPEAT);
+}
+
+// Loudest of harmonics 2..BENCH_HARMONICS of one cycle, in dB relative to
+// the fundamental. Naive DFT, only the few bins we need.
+static double bench_worst_harmonic_db(bench_fn fn)
+{
+    static double cycle[BENCH_DFT_SIZE];
+    for (int i = 0; i < BENCH_DFT_SIZE; ++i)
+    {
+        cycle[i] = fn((float)(TR_TWOPI * i / BENCH_DFT_SIZE));
+    }
+
+    double fundamental = 0.0;
+    double worst = 0.0;
+
+    for (int k = 1; k <= BENCH_HARMONICS; ++k)
+    {
+        double re = 0.0;
+        double im = 0.0;
+        for (int i = 0; i < BENCH_DFT_SIZE; ++i)
+        {
+            const double a = 2.0 * TR_PI * k * i / BENCH_DFT_SIZE;
+            re += cycle[i] * __builtin_cos(a);
+            im -= cycle[i] * __builtin_sin(a);
+        }
+
+        const double mag = __builtin_sqrt(re * re + im * im);
+        if (k == 1) fundamental = mag;
+        else if (mag > worst) worst = mag;
+    }
+
+    return worst > 0.0 ? 20.0 * __builtin_log10(worst / fundamental) : -999.0;
+}
+
+int main(void)
+{
+    printf("%-6s %-8s %14s %12s %10s %12s\n", "func", "tier", "max ulp", "max abs", "ns/sample", "harmonic dB");
+
+    for (size_t f = 0; f < tr_countof(g_funcs); ++f)
+    {
+        const bench_func_t* func = &g_funcs[f];
+
+        for (int t = 0; t < 3; ++t)
+        {
+            double max_ulp, max_abs;
+            bench_error(func, func->tiers[t], &max_ulp, &max_abs);
+            const double ns = bench_speed(func, func->bufs[t]);
+
+            printf("%-6s %-8s %14.1f %12.3g %10.2f", func->name, g_tier_names[t], max_ulp, max_abs, ns);
+
+            if (func->ref == ref_sin)
+            {
+                printf(" %12.1f", bench_worst_harmonic_db(func->tiers[t]));
+            }
+
+            printf("\n");
+        }
+    }
+
+    return 0;
+}
@@ -73,7 +73,7 @@ enum type_type
     TYPE_FLOAT,
     TYPE_INT,
     TYPE_TR_INPUT,
-    TYPE_TR_BUF,
+    TYPE_TR_OUTPUT,
     TYPE_ENUM,
 };
 
@@ -107,6 +107,12 @@ typedef struct module
 
     size_t field_count;
     field_t fields[64];
+
+    // hooks implemented in the source files listed in g_hook_sources
+    int has_update;
+    int has_decorate;
+    int has_specialize;
+    int has_update_batch;
 } module_t;
 
 size_t module_count = 0;
@@ -115,6 +121,99 @@ module_t modules[64];
 size_t enum_count;
 enum_t enums[64];
 
+// Files scanned for module hooks (tr_xxx_update, tr_xxx_decorate, tr_xxx_specialize, tr_xxx_update_batch).
+static const char* g_hook_sources[] = {
+    "src/modules.c",
+    "src/main.c",
+};
+
+static char* read_file(const char* path, int* len)
+{
+    FILE* f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        return NULL;
+    }
+
+    char* src = (char*)malloc(1 << 20);
+    *len = (int)fread(src, 1, 1 << 20, f);
+    fclose(f);
+    return src;
+}
+
+// Looks for "void <name>(" which matches both prototypes and definitions.
+static void scan_hooks(const char* path)
+{
+    int src_len;
+    char* src = read_file(path, &src_len);
+    if (src == NULL)
+    {
+        printf("Error opening file \"%s\"\n", path);
+        exit(1);
+    }
+
+    stb_lexer lex;
+    char* store = (char*)malloc(0x10000);
+    stb_c_lexer_init(&lex, src, src + src_len, store, 0x10000);
+
+    // 1 after "void", 2 after "tr_module_update_fn"
+    int prev_return_type = 0;
+    while (next_token(&lex))
+    {
+        if (lex.token != CLEX_id)
+        {
+            prev_return_type = 0;
+            continue;
+        }
+
+        if (strcmp(lex.string, "void") == 0)
+        {
+            prev_return_type = 1;
+            continue;
+        }
+
+        if (strcmp(lex.string, "tr_module_update_fn") == 0)
+        {
+            prev_return_type = 2;
+            continue;
+        }
+
+        const int return_type = prev_return_type;
+        prev_return_type = 0;
+        if (return_type == 0)
+        {
+            continue;
+        }
+
+        char name[256];
+        snprintf(name, sizeof(name), "%s", lex.string);
+
+        next_token(&lex);
+        if (lex.token != '(')
+        {
+            continue;
+        }
+
+        for (size_t i = 0; i < module_count; ++i)
+        {
+            module_t* module = &modules[i];
+            const size_t id_len = strlen(module->id);
+            if (strncmp(name, module->id, id_len) != 0)
+            {
+                continue;
+            }
+
+            if (return_type == 1 && strcmp(name + id_len, "_update") == 0) module->has_update = 1;
+            if (return_type == 1 && strcmp(name + id_len, "_decorate") == 0) module->has_decorate = 1;
+            if (return_type == 2 && strcmp(name + id_len, "_specialize") == 0) module->has_specialize = 1;
+            if (return_type == 1 && strcmp(name + id_len, "_update_batch") == 0) module->has_update_batch = 1;
+        }
+    }
+
+    free(store);
+    free(src);
+}
+
 static void parse_type(type_t* type, stb_lexer* lex)
 {
     assert(lex->token == CLEX_id);
@@ -126,9 +225,9 @@ static void parse_type(type_t* type, stb_lexer* lex)
     {
         type->type = TYPE_INT;
     }
-    else if (strcmp(lex->string, "tr_buf") == 0)
+    else if (strcmp(lex->string, "tr_output") == 0)
     {
-        type->type = TYPE_TR_BUF;
+        type->type = TYPE_TR_OUTPUT;
     }
     else if (strcmp(lex->string, "tr_input") == 0)
     {
@@ -165,6 +264,22 @@ static void write_module_type_enum(FILE* f, const module_t* modules, size_t coun
     }
     fprintf(f, "\tTR_MODULE_COUNT\n");
     fprintf(f, "};\n");
+
+    // most tr_output fields of a single module, sizes the rack's buffer pool
+    size_t output_count_max = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t output_count = 0;
+        for (size_t field_index = 0; field_index < modules[i].field_count; ++field_index)
+        {
+            output_count += modules[i].fields[field_index].type.type == TYPE_TR_OUTPUT;
+        }
+        if (output_count > output_count_max)
+        {
+            output_count_max = output_count;
+        }
+    }
+    fprintf(f, "#define TR_MODULE_OUTPUT_COUNT_MAX %zu\n", output_count_max);
 }
 
 static void write_module_fields_enum(FILE* f, const module_t* module)
@@ -225,7 +340,7 @@ static void write_module_field_infos(FILE* f, const module_t* module)
                 field_type = "TR_MODULE_FIELD_FLOAT";    
             }
         }
-        else if (field->type.type == TYPE_TR_BUF)
+        else if (field->type.type == TYPE_TR_OUTPUT)
         {
             field_type = "TR_MODULE_FIELD_BUFFER";
         }
@@ -250,6 +365,84 @@ static void write_module_typedef(FILE* f, const module_t* module)
     fprintf(f, "typedef struct %s %s_t;\n", module->id, module->id);
 }
 
+static void write_module_hooks(FILE* f, const module_t* module)
+{
+    if (module->has_update)
+    {
+        fprintf(f, "void %s_update(%s_t* module);\n", module->id, module->id);
+    }
+    if (module->has_decorate)
+    {
+        fprintf(f, "void %s_decorate(%s_t* module, struct tr_gui_module* gui_module);\n", module->id, module->id);
+    }
+    if (module->has_specialize)
+    {
+        fprintf(f, "tr_module_update_fn %s_specialize(const %s_t* module);\n", module->id, module->id);
+    }
+    if (module->has_update_batch)
+    {
+        fprintf(f, "void %s_update_batch(%s_t** modules, size_t count);\n", module->id, module->id);
+    }
+
+    fprintf(f, "static inline void %s__init(void* data)\n", module->id);
+    fprintf(f, "{\n");
+    fprintf(f, "\tstruct %s* module = (struct %s*)data;\n", module->id, module->id);
+    fprintf(f, "\t(void)module;\n");
+    for (size_t i = 0; i < module->field_count; ++i)
+    {
+        const field_t* field = &module->fields[i];
+        if (field->type.type == TYPE_FLOAT && field->has_attr)
+        {
+            fprintf(f, "\tmodule->%s = %ff;\n", field->id, field->attr_default);
+        }
+    }
+    fprintf(f, "}\n");
+}
+
+static void write_module_vtable(FILE* f, const module_t* modules, size_t count)
+{
+    fprintf(f, "static const struct tr_module_vtable tr_module_vtable[TR_MODULE_COUNT] = {\n");
+    for (size_t i = 0; i < count; ++i)
+    {
+        const module_t* module = &modules[i];
+        fprintf(f, "\t[%s] = {", module->id_upper);
+        if (module->has_update)
+        {
+            fprintf(f, "(tr_module_update_fn)%s_update, ", module->id);
+        }
+        else
+        {
+            fprintf(f, "NULL, ");
+        }
+        if (module->has_decorate)
+        {
+            fprintf(f, "(tr_module_decorate_fn)%s_decorate, ", module->id);
+        }
+        else
+        {
+            fprintf(f, "NULL, ");
+        }
+        if (module->has_specialize)
+        {
+            fprintf(f, "(tr_module_specialize_fn)%s_specialize, ", module->id);
+        }
+        else
+        {
+            fprintf(f, "NULL, ");
+        }
+        if (module->has_update_batch)
+        {
+            fprintf(f, "(tr_module_batch_fn)%s_update_batch, ", module->id);
+        }
+        else
+        {
+            fprintf(f, "NULL, ");
+        }
+        fprintf(f, "%s__init},\n", module->id);
+    }
+    fprintf(f, "};\n");
+}
+
 static void write_module_infos(FILE* f, const module_t* modules, size_t count)
 {
     fprintf(f, "static const struct tr_module_info tr_module_infos[] = {\n");
@@ -261,7 +454,15 @@ static void write_module_infos(FILE* f, const module_t* modules, size_t count)
         const int height = module->attr_height;
         fprintf(f, "\t[%s] = {\"%s\", sizeof(struct %s), %s__fields, %zu, %d, %d},\n", module->id_upper, name, module->id, module->id, module->field_count, width, height);
     }
-    fprintf(f, "};");
+    fprintf(f, "};\n");
+
+    // as large as the largest struct_size, for static checks
+    fprintf(f, "union tr_module_data\n{\n");
+    for (size_t i = 0; i < count; ++i)
+    {
+        fprintf(f, "\tstruct %s %s;\n", modules[i].id, modules[i].id);
+    }
+    fprintf(f, "};\n");
 }
 
 int main(int argc, char** argv)
@@ -467,6 +668,11 @@ int main(int argc, char** argv)
         next_token(&lex);
         assert(lex.token == ';');
     }
+
+    for (size_t i = 0; i < sizeof(g_hook_sources) / sizeof(g_hook_sources[0]); ++i)
+    {
+        scan_hooks(g_hook_sources[i]);
+    }
     
     // for (size_t module_index = 0; module_index < module_count; ++module_index)
     // {
@@ -491,6 +697,8 @@ int main(int argc, char** argv)
     fprintf(f, "#include \"modules.types.h\"\n");
     fprintf(f, "#include \"modules2.h\"\n");
     fprintf(f, "\n");
+    fprintf(f, "struct tr_gui_module;\n");
+    fprintf(f, "\n");
 #if ALL_MODULES_PORTED
     write_module_type_enum(f, modules, module_count);
 #endif
@@ -499,9 +707,11 @@ int main(int argc, char** argv)
         write_module_fields_enum(f, &modules[module_index]);
         write_module_field_infos(f, &modules[module_index]);
         write_module_typedef(f, &modules[module_index]);
+        write_module_hooks(f, &modules[module_index]);
     }
 #if ALL_MODULES_PORTED
     write_module_infos(f, modules, module_count);
+    write_module_vtable(f, modules, module_count);
 #endif
     fclose(f);
 
@@ -1,20 +1,37 @@
+// Plays the ring the engine renders into, see tr_audio_ring_t in main.c:
+// write and read indices in frames, the frame count, then the samples from
+// byte 16. Indices are int32 here, differences are taken with | 0.
 class A extends AudioWorkletProcessor {
   constructor({processorOptions}) {
     super();
-    const {sab, count} = processorOptions;
-    this.buf = [];
-    for (let i = 0; i < count; ++i) {
-      this.buf.push(new Float32Array(sab, i * 4 * 128, 128));
-    }
-    this.count = count;
-    this.i = 0;
+    const {buffer, ptr, wake} = processorOptions;
+    this.indices = new Int32Array(buffer, ptr, 3);
+    this.frames = this.indices[2];
+    this.samples = new Float32Array(buffer, ptr + 16, this.frames);
+    // single-threaded build: the main thread renders when asked, once per
+    // write index
+    this.wake = wake;
+    this.asked = -1;
   }
 
   process(_, outputs) {
     const channel = outputs[0][0];
-    channel.set(this.buf[this.i]);
-    this.port.postMessage(this.buf[this.i]);
-    this.i = (this.i + 1) % this.count;
+    const write = Atomics.load(this.indices, 0);
+    const read = Atomics.load(this.indices, 1);
+    const available = (write - read) | 0;
+
+    // on underrun the quantum stays silent
+    if (available >= channel.length) {
+      const offset = read & (this.frames - 1);
+      channel.set(this.samples.subarray(offset, offset + channel.length));
+      Atomics.store(this.indices, 1, read + channel.length);
+      Atomics.notify(this.indices, 1);
+    }
+
+    if (this.wake && available - channel.length <= this.frames / 2 && this.asked !== write) {
+      this.asked = write;
+      this.port.postMessage(0);
+    }
     return true;
   }
 }
@@ -0,0 +1,46 @@
+#include "cmdqueue.h"
+
+bool tr_command_queue_push(tr_command_queue_t* queue, const tr_command_t* command)
+{
+    const unsigned write = atomic_load_explicit(&queue->write, memory_order_relaxed);
+    const unsigned read = atomic_load_explicit(&queue->read, memory_order_acquire);
+    if (write - read == TR_COMMAND_QUEUE_SIZE)
+    {
+        return false;
+    }
+
+    queue->commands[write & (TR_COMMAND_QUEUE_SIZE - 1)] = *command;
+    atomic_store_explicit(&queue->write, write + 1, memory_order_release);
+    return true;
+}
+
+bool tr_command_queue_can_push(tr_command_queue_t* queue)
+{
+    const unsigned write = atomic_load_explicit(&queue->write, memory_order_relaxed);
+    const unsigned read = atomic_load_explicit(&queue->read, memory_order_acquire);
+    return write - read != TR_COMMAND_QUEUE_SIZE;
+}
+
+bool tr_command_queue_try_begin(tr_command_queue_t* queue)
+{
+    return !atomic_flag_test_and_set_explicit(&queue->consumer, memory_order_acquire);
+}
+
+bool tr_command_queue_pop(tr_command_queue_t* queue, tr_command_t* command)
+{
+    const unsigned read = atomic_load_explicit(&queue->read, memory_order_relaxed);
+    const unsigned write = atomic_load_explicit(&queue->write, memory_order_acquire);
+    if (read == write)
+    {
+        return false;
+    }
+
+    *command = queue->commands[read & (TR_COMMAND_QUEUE_SIZE - 1)];
+    atomic_store_explicit(&queue->read, read + 1, memory_order_release);
+    return true;
+}
+
+void tr_command_queue_end(tr_command_queue_t* queue)
+{
+    atomic_flag_clear_explicit(&queue->consumer, memory_order_release);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "types.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Edits from the UI to the rack, applied by the audio engine between two
+// blocks (see tr_rack_apply_commands). Modules and fields are referred to by
+// index, the same way the patch format does.
+
+typedef enum tr_command_type
+{
+    TR_COMMAND_SET_FLOAT,
+    TR_COMMAND_SET_INT,
+    TR_COMMAND_CONNECT,
+    TR_COMMAND_DISCONNECT,
+    TR_COMMAND_ADD_MODULE,
+    TR_COMMAND_REMOVE_MODULE,
+} tr_command_type_t;
+
+typedef struct tr_command
+{
+    uint8_t type; // tr_command_type_t
+    uint16_t module;
+    uint16_t field;
+    union
+    {
+        float float_value; // TR_COMMAND_SET_FLOAT
+        int int_value; // TR_COMMAND_SET_INT
+        struct
+        {
+            uint16_t module;
+            uint16_t field;
+            color_t color;
+        } source; // TR_COMMAND_CONNECT
+    };
+} tr_command_t;
+
+#define TR_COMMAND_QUEUE_SIZE 1024 // power of two
+
+// Single producer (UI), single consumer (engine).
+typedef struct tr_command_queue
+{
+    tr_command_t commands[TR_COMMAND_QUEUE_SIZE];
+    atomic_uint write; // only written by the producer
+    atomic_uint read; // only written by the consumer
+    atomic_flag consumer; // taken while draining, see tr_command_queue_try_begin
+} tr_command_queue_t;
+
+// Returns false when the queue is full, the command is dropped.
+bool tr_command_queue_push(tr_command_queue_t* queue, const tr_command_t* command);
+
+// Producer side only: a free slot stays free until the producer pushes, so
+// the next push is known to succeed.
+bool tr_command_queue_can_push(tr_command_queue_t* queue);
+
+// The consumer side must be claimed before popping. It's normally always the
+// engine, but the UI drains the queue itself until the engine takes over.
+bool tr_command_queue_try_begin(tr_command_queue_t* queue);
+bool tr_command_queue_pop(tr_command_queue_t* queue, tr_command_t* command);
+void tr_command_queue_end(tr_command_queue_t* queue);
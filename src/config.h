@@ -1,6 +1,63 @@
 #pragma once
 
 #define TR_SAMPLE_RATE  48000
+// Samples rendered per block. 128 matches the AudioWorklet quantum, 512
+// spreads the per-block work (commands, schedule checks) over more
+// samples. Override with -DTR_SAMPLE_COUNT=128, see make.bat. Kernels loop
+// over this constant so the compiler unrolls and vectorizes for the size.
+#ifndef TR_SAMPLE_COUNT
 #define TR_SAMPLE_COUNT (512) // 512/48000 ~= 10ms
+#endif
+
+_Static_assert(TR_SAMPLE_COUNT == 64 || TR_SAMPLE_COUNT == 128 || TR_SAMPLE_COUNT == 256 || TR_SAMPLE_COUNT == 512, "unsupported block size");
+
+// Samples between two coefficient updates of the lp filter when its cutoff
+// moves slowly, the coefficient is interpolated in between. Audio-rate
+// cutoff modulation is still computed for every sample.
+#ifndef TR_LP_CONTROL_RATE
+#define TR_LP_CONTROL_RATE (16)
+#endif
+
+_Static_assert(TR_LP_CONTROL_RATE >= 1 && TR_LP_CONTROL_RATE <= 64 && (TR_LP_CONTROL_RATE & (TR_LP_CONTROL_RATE - 1)) == 0, "unsupported lp control rate");
+
+// Frames pulled by the AudioWorklet per callback.
+#define TR_AUDIO_QUANTUM (128)
+
+// Frames buffered between the engine and the AudioWorklet (tr_audio_ring_t),
+// about 21ms. A power of two holding whole blocks and whole quanta.
+#define TR_AUDIO_RING_FRAMES (1024)
+
+_Static_assert((TR_AUDIO_RING_FRAMES & (TR_AUDIO_RING_FRAMES - 1)) == 0 && TR_AUDIO_RING_FRAMES >= 2 * TR_SAMPLE_COUNT && TR_AUDIO_RING_FRAMES % TR_AUDIO_QUANTUM == 0, "unsupported audio ring size");
+
+// Copy the module data into a fresh arena in update order each time the
+// schedule is rebuilt, so a block walks it front to back. Off with wasm
+// threads: the UI thread allocates module data and keeps pointers into it
+// while the engine compiles.
+#ifndef TR_RELOCATE_MODULES
+#ifdef TR_WASM_THREADS
+#define TR_RELOCATE_MODULES 0
+#else
+#define TR_RELOCATE_MODULES 1
+#endif
+#endif
+
+#if TR_RELOCATE_MODULES && defined(TR_WASM_THREADS)
+#error "TR_RELOCATE_MODULES needs the UI and the engine on the same thread"
+#endif
+
+// Accuracy of tr_sinf, tr_expf, etc. and their _buf versions, see math.c.
+// fast is a parabolic sine and 3 term series, precise is within a few ulp.
+// Override with -DTR_MATH_TIER=TR_MATH_PRECISE, run mathbench to compare.
+#define TR_MATH_FAST    0
+#define TR_MATH_MEDIUM  1
+#define TR_MATH_PRECISE 2
+
+#ifndef TR_MATH_TIER
+#define TR_MATH_TIER TR_MATH_FAST
+#endif
+
+// Modules of the same level and type that the schedule hands to their
+// tr_xxx_update_batch hook in one call, one per tr_v4 lane (simd.h).
+#define TR_SCHEDULE_BATCH_WIDTH (4)
 
 #define tr_countof(_Array) (sizeof(_Array) / sizeof(_Array[0]))
\ No newline at end of file
@@ -0,0 +1,27 @@
+// Audio engine of the threads build. Shares the wasm memory with the UI
+// instance and keeps the audio ring full, the worklet reads it directly.
+onmessage = async ({data}) => {
+  const {module, memory} = data;
+
+  const instance = await WebAssembly.instantiate(module, {
+    env: {
+      memory,
+      js_now: () => performance.now(),
+      js_init: () => {},
+      js_render: () => {},
+      js_set_cursor: () => {},
+      console_log: (ptr) => {
+        const mem = new Uint8Array(memory.buffer);
+        let s = "";
+        for (let i = ptr; mem[i] !== 0; i++) {
+          s += String.fromCharCode(mem[i]);
+        }
+        console.log(s);
+      },
+    },
+  });
+  instance.exports.__stack_pointer.value = instance.exports.tr_engine_stack_top();
+
+  // never returns, waits on the ring's read index when it's full
+  instance.exports.tr_engine_run();
+};
@@ -5,10 +5,12 @@
 #include "math.h"
 #include "stdlib.h"
 #include "strbuf.h"
+#include "cmdqueue.h"
 
 #include <stdbool.h>
 #include <stdint.h>
 #include <float.h>
+#include <stdatomic.h>
 
 // debug stuff
 #define TR_TRACE_MODULE_UPDATES 0
@@ -25,6 +27,7 @@
 
 #define COLOR_BACKGROUND COLOR_FROM_RGBA_HEX(0x3c5377ff)
 #define COLOR_MODULE_BACKGROUND COLOR_FROM_RGBA_HEX(0xfff3c2ff)
+#define COLOR_MODULE_BACKGROUND_PRUNED COLOR_FROM_RGBA_HEX(0xc9c2a8ff)
 #define COLOR_MODULE_TEXT COLOR_FROM_RGBA_HEX(0x3c5377ff)
 #define COLOR_PLUG_HOLE COLOR_FROM_RGBA_HEX(0x303030ff)
 #define COLOR_PLUG_BORDER COLOR_FROM_RGBA_HEX(0xa5a5a5ff)
@@ -42,110 +45,196 @@
 
 #define TR_CABLE_ALPHA 0.75f
 
-#define TR_MODULE_DATA_POOL_SIZE (16 * 1024 * 1024)
+// With TR_RELOCATE_MODULES the pool alternates between two arenas, see
+// tr_relocate_modules.
+#if TR_RELOCATE_MODULES
+#define TR_MODULE_POOL_ARENA_COUNT (2)
+#else
+#define TR_MODULE_POOL_ARENA_COUNT (1)
+#endif
+#define TR_MODULE_DATA_POOL_SIZE (64 * 1024 * 1024 / TR_MODULE_POOL_ARENA_COUNT)
+
+// Module data is allocated in size classes of TR_MODULE_POOL_CLASS bytes.
+// A freed block goes on the free list of its class and is handed to the next
+// module of the same size, the list is linked through the first bytes of
+// the free blocks.
+#define TR_MODULE_POOL_CLASS (16)
+#define TR_MODULE_POOL_CLASS_COUNT (256)
 
 typedef struct tr_module_pool
 {
     uint8_t* data;
     size_t offset;
+    size_t arena; // index in g_module_pool_memory
+    void* free_lists[TR_MODULE_POOL_CLASS_COUNT];
 } tr_module_pool_t;
 
+_Static_assert((sizeof(union tr_module_data) + TR_MODULE_POOL_CLASS - 1) / TR_MODULE_POOL_CLASS < TR_MODULE_POOL_CLASS_COUNT, "a module struct is larger than the largest pool class");
+
+static size_t tr_module_pool_class(size_t size)
+{
+    return (size + TR_MODULE_POOL_CLASS - 1) / TR_MODULE_POOL_CLASS;
+}
+
 static void* tr_module_pool_alloc(tr_module_pool_t* pool, size_t size)
 {
-    void* data = pool->data + pool->offset;
-    pool->offset += size;
+    const size_t size_class = tr_module_pool_class(size);
+
+    void* data = pool->free_lists[size_class];
+    if (data != NULL)
+    {
+        pool->free_lists[size_class] = *(void**)data;
+        return data;
+    }
+
+    assert(pool->offset + size_class * TR_MODULE_POOL_CLASS <= TR_MODULE_DATA_POOL_SIZE);
+    data = pool->data + pool->offset;
+    pool->offset += size_class * TR_MODULE_POOL_CLASS;
     return data;
 }
 
+static void tr_module_pool_free(tr_module_pool_t* pool, void* data, size_t size)
+{
+    const size_t size_class = tr_module_pool_class(size);
+    *(void**)data = pool->free_lists[size_class];
+    pool->free_lists[size_class] = data;
+}
+
 typedef struct tr_gui_module
 {
     float x, y;
     enum tr_module_type type;
     void* data; // pointer to the real module data (tr_vco_t, tr_clock_t, etc...) based on type
+    atomic_bool pruned; // can't reach a speaker or scope, not updated. Set by the engine, drawn by the UI.
+    uint8_t scope_view; // scopes: 1 + index in g_scope_views, 0 for none
+    // Set by the UI when the module is deleted, the slot is skipped from then
+    // on. The engine sets released once no schedule refers to the module, the
+    // UI can then free the data and reuse the slot (tr_rack_reclaim_modules).
+    // Both are read by the other thread.
+    atomic_bool removed;
+    atomic_bool released;
 } tr_gui_module_t;
 
 #define TR_GUI_MODULE_COUNT 1024
 #define TR_MAX_CABLES (4 * 1024)
+#define TR_MODULE_FIELD_COUNT_MAX (64) // same as modcc
 
-typedef struct tr_output_plug
+// A cable from an output to an input, both ends given as module and field
+// index. Input pointers follow the buffer their source is given by each
+// schedule, the cable itself is recorded here. Cable 0 is never used, 0
+// stands for no cable in the tables of rack_t.
+typedef struct tr_cable
 {
-    const tr_gui_module_t* module;
-    const tr_module_field_info_t* field;
-} tr_output_plug_t;
-
-typedef struct tr_input_plug
+    color_t color;
+    bool feedback; // reads the previous block, see tr_resolve_module_graph
+    uint16_t source_module;
+    uint16_t source_field;
+    uint16_t target_module;
+    uint16_t target_field;
+    uint16_t next_input; // next cable into target_module, or next free cable
+    uint16_t next_output; // next cable out of source_module
+} tr_cable_t;
+
+// Input as the UI last set it, see rack_t.gui_cables.
+typedef struct tr_gui_cable
 {
+    bool connected;
     color_t color;
-} tr_input_plug_t;
+    uint16_t source_module;
+    uint16_t source_field;
+} tr_gui_cable_t;
+
+// What a scope shows, published by the engine after each block. Triple
+// buffered: the engine fills back and swaps it with middle, the UI swaps
+// middle with front when a new block is in. Neither waits, and neither reads
+// the buffer the other one holds, so the UI never touches the scope's input.
+#define TR_SCOPE_VIEW_COUNT (64)
+#define TR_SCOPE_VIEW_FRESH (4u) // middle holds a block the UI hasn't taken
+
+typedef struct tr_scope_view
+{
+    float samples[3][TR_SAMPLE_COUNT];
+    bool connected[3];
+    atomic_uint middle; // buffer index, | TR_SCOPE_VIEW_FRESH
+    unsigned back; // engine only
+    unsigned front; // UI only
+} tr_scope_view_t;
+
+// Flat update order compiled from the module graph. Only rebuilt when the
+// topology changes (modules added, cables connected, patch loaded), so the
+// audio callback just walks the array.
+//
+// Entries are grouped by level: modules of the same level don't read each
+// other's outputs, so they can be regrouped into batches.
+typedef struct tr_schedule_entry
+{
+    tr_module_update_fn update;
+    void* data;
+} tr_schedule_entry_t;
+
+// Same-type modules of one level updated by a single batch call, the entry
+// pointing to it runs tr_schedule_batch_update.
+typedef struct tr_schedule_batch
+{
+    tr_module_batch_fn update;
+    size_t count;
+    void* modules[TR_SCHEDULE_BATCH_WIDTH];
+} tr_schedule_batch_t;
+
+typedef struct tr_schedule
+{
+    bool valid;
+    tr_gui_module_t* modules[TR_GUI_MODULE_COUNT];
+    uint16_t module_levels[TR_GUI_MODULE_COUNT];
+    size_t module_count;
+    tr_schedule_entry_t entries[TR_GUI_MODULE_COUNT]; // modules that have an update function
+    size_t entry_count;
+    tr_schedule_batch_t batches[TR_GUI_MODULE_COUNT];
+    size_t batch_count;
+    const tr_speaker_t* speaker;
+    const tr_gui_module_t* scopes[TR_SCOPE_VIEW_COUNT];
+    size_t scope_count;
+} tr_schedule_t;
 
 typedef struct rack
 {
     tr_module_pool_t module_pool;
     tr_gui_module_t gui_modules[TR_GUI_MODULE_COUNT];
-    size_t gui_module_count;
-    uint32_t output_plugs_key[TR_MAX_CABLES];
-    tr_output_plug_t output_plugs[TR_MAX_CABLES];
-    uint32_t input_plugs_key[TR_MAX_CABLES];
-    tr_input_plug_t input_plugs[TR_MAX_CABLES];
+    atomic_size_t gui_module_count; // incremented by the UI once the slot is complete
+    // An input takes at most one cable, input_cables[module][field] is that
+    // cable. The engine edits the cables when it applies the commands, the UI
+    // reads gui_cables instead.
+    tr_cable_t cables[TR_MAX_CABLES];
+    uint16_t cable_count; // cables[0, cable_count) are in use or free
+    uint16_t free_cables; // linked through next_input
+    uint16_t input_cables[TR_GUI_MODULE_COUNT][TR_MODULE_FIELD_COUNT_MAX];
+    uint16_t first_input_cable[TR_GUI_MODULE_COUNT];
+    uint16_t first_output_cable[TR_GUI_MODULE_COUNT];
+    // The UI's copy of input_cables, updated as it queues the cable commands
+    // (tr_rack_push_command). Drawing and saving read this one, the cable
+    // table above is only touched by the engine.
+    tr_gui_cable_t gui_cables[TR_GUI_MODULE_COUNT][TR_MODULE_FIELD_COUNT_MAX];
+    tr_schedule_t schedule;
+    uint16_t releasing[TR_GUI_MODULE_COUNT]; // removed, released by the next schedule
+    size_t releasing_count;
+    uint64_t scope_views_used; // bit per g_scope_views entry, UI only
 } rack_t;
 
-static uint8_t g_module_pool_memory[64 * 1024 * 1024];
+static _Alignas(16) uint8_t g_module_pool_memory[TR_MODULE_POOL_ARENA_COUNT][TR_MODULE_DATA_POOL_SIZE];
+
+// Storage of every tr_output, handed out by tr_assign_buffers. Buffer 0 stays
+// silent: outputs of modules that aren't updated point to it. There is one
+// buffer per output of a full rack, so the liveness pass can't run out
+// whatever the patch, it only keeps the working set small.
+#define TR_BUFFER_POOL_COUNT (1 + TR_GUI_MODULE_COUNT * TR_MODULE_OUTPUT_COUNT_MAX)
+_Static_assert(TR_BUFFER_POOL_COUNT <= UINT16_MAX, "buffer indices are uint16_t");
+static _Alignas(16) float g_buffer_pool[TR_BUFFER_POOL_COUNT][TR_SAMPLE_COUNT];
+_Static_assert(TR_SCOPE_VIEW_COUNT <= 64, "rack_t.scope_views_used is a uint64_t");
+static tr_scope_view_t g_scope_views[TR_SCOPE_VIEW_COUNT];
 static uint8_t g_null_module[64 * 1024];
 static uint8_t g_rb_memory[1024 * 1024];
 static render_buffer_t g_rb = {g_rb_memory};
 
-static inline uint32_t tr_ptr_hash32(const void *p)
-{
-    uint32_t x = (uint32_t)(uintptr_t)p;
-    x ^= x >> 16;
-    x *= 0x7feb352dU;
-    x ^= x >> 15;
-    x *= 0x846ca68bU;
-    x ^= x >> 16;
-    return x;
-}
-
-// -1 if not found
-static int tr_hmget(const uint32_t* keys, const void* key)
-{
-    const uint32_t hash = tr_ptr_hash32(key);
-    const size_t offset = hash % TR_MAX_CABLES;
-    for (size_t i = 0; i < TR_MAX_CABLES; ++i)
-    {
-        const size_t j = (offset + i) % TR_MAX_CABLES;
-        const uint32_t k = keys[j];
-        if (k == hash)
-        {
-            return (int)j;
-        }
-        else if (k == 0u)
-        {
-            return -1;
-        }
-    }
-
-    return -1;
-}
-
-static int tr_hmput(uint32_t* keys, const void* key)
-{
-    const uint32_t hash = tr_ptr_hash32(key);
-    const size_t offset = hash % TR_MAX_CABLES;
-
-    for (size_t i = 0; i < TR_MAX_CABLES; ++i)
-    {
-        const size_t j = (offset + i) % TR_MAX_CABLES;
-        const uint32_t k = keys[j];
-        if (k == 0u || k == hash)
-        {
-            keys[j] = hash;
-            return (int)j;
-        }
-    }
-
-    return -1; // we goofed
-}
-
 static void draw_rectangle_rounded(rectangle_t rec, float roundness, color_t color)
 {
     cmd_draw_rectangle_rounded_t* cmd = rb_draw_rectangle_rounded(&g_rb);
@@ -174,41 +263,292 @@ void* get_field_address(const tr_gui_module_t* module, size_t field_index)
     return (uint8_t*)module->data + field_offset;
 }
 
+void tr_rack_invalidate_schedule(rack_t* rack)
+{
+    rack->schedule.valid = false;
+}
+
+// Unplugs the input and unlinks its cable from the lists of both modules.
+static void tr_rack_disconnect(rack_t* rack, size_t module_index, size_t field_index)
+{
+    *(const float**)get_field_address(&rack->gui_modules[module_index], field_index) = NULL;
+
+    const uint16_t cable_index = rack->input_cables[module_index][field_index];
+    if (cable_index == 0)
+    {
+        return;
+    }
+
+    tr_cable_t* cable = &rack->cables[cable_index];
+
+    uint16_t* link = &rack->first_input_cable[cable->target_module];
+    while (*link != cable_index)
+    {
+        link = &rack->cables[*link].next_input;
+    }
+    *link = cable->next_input;
+
+    link = &rack->first_output_cable[cable->source_module];
+    while (*link != cable_index)
+    {
+        link = &rack->cables[*link].next_output;
+    }
+    *link = cable->next_output;
+
+    rack->input_cables[module_index][field_index] = 0;
+    cable->next_input = rack->free_cables;
+    rack->free_cables = cable_index;
+}
+
+// Plugs the target input into the source output, replacing the cable the
+// input had.
+static void tr_rack_connect(rack_t* rack, tr_cable_t cable)
+{
+    tr_rack_disconnect(rack, cable.target_module, cable.target_field);
+
+    uint16_t cable_index = rack->free_cables;
+    if (cable_index != 0)
+    {
+        rack->free_cables = rack->cables[cable_index].next_input;
+    }
+    else
+    {
+        assert(rack->cable_count < TR_MAX_CABLES);
+        cable_index = rack->cable_count++;
+    }
+
+    cable.next_input = rack->first_input_cable[cable.target_module];
+    cable.next_output = rack->first_output_cable[cable.source_module];
+    rack->cables[cable_index] = cable;
+    rack->first_input_cable[cable.target_module] = cable_index;
+    rack->first_output_cable[cable.source_module] = cable_index;
+    rack->input_cables[cable.target_module][cable.target_field] = cable_index;
+
+    const float** input = get_field_address(&rack->gui_modules[cable.target_module], cable.target_field);
+    float* const* output = get_field_address(&rack->gui_modules[cable.source_module], cable.source_field);
+    *input = *output;
+}
+
+// First cable into the module, next_input chains the others. Removed modules
+// are skipped, they may not be disconnected yet.
+static uint16_t tr_rack_first_input_cable(const rack_t* rack, size_t module_index)
+{
+    return rack->gui_modules[module_index].removed ? 0 : rack->first_input_cable[module_index];
+}
+
+#ifdef TR_WASM_THREADS
+// Stack of the engine worker, every wasm instance starts with the same
+// __stack_pointer and the worker moves its own here.
+static _Alignas(16) uint8_t g_engine_stack[256 * 1024];
+
+void* tr_engine_stack_top(void)
+{
+    return g_engine_stack + sizeof(g_engine_stack);
+}
+#endif
+
+// Returns 1 + the index of a free g_scope_views entry, 0 when all are taken:
+// the scope then stays blank.
+static uint8_t tr_rack_alloc_scope_view(rack_t* rack)
+{
+    for (unsigned i = 0; i < TR_SCOPE_VIEW_COUNT; ++i)
+    {
+        if (rack->scope_views_used & (1ull << i))
+        {
+            continue;
+        }
+
+        // the engine only sees the view once the module is published
+        tr_scope_view_t* view = &g_scope_views[i];
+        memset(view->connected, 0, sizeof(view->connected));
+        view->back = 0;
+        view->front = 2;
+        atomic_store_explicit(&view->middle, 1, memory_order_relaxed);
+
+        rack->scope_views_used |= 1ull << i;
+        return (uint8_t)(i + 1);
+    }
+
+    return 0;
+}
+
+// Gives the data of the modules the engine has released back to the pool.
+// Their slots are reused by tr_rack_create_module.
+void tr_rack_reclaim_modules(rack_t* rack)
+{
+    for (size_t i = 0; i < rack->gui_module_count; ++i)
+    {
+        tr_gui_module_t* module = &rack->gui_modules[i];
+        if (module->data == NULL || !atomic_load_explicit(&module->released, memory_order_acquire))
+        {
+            continue;
+        }
+
+        tr_module_pool_free(&rack->module_pool, module->data, tr_module_infos[module->type].struct_size);
+        module->data = NULL;
+
+        if (module->scope_view != 0)
+        {
+            rack->scope_views_used &= ~(1ull << (module->scope_view - 1));
+            module->scope_view = 0;
+        }
+    }
+}
+
 tr_gui_module_t* tr_rack_create_module(rack_t* rack, enum tr_module_type type)
 {
-    assert(rack->gui_module_count < TR_GUI_MODULE_COUNT);
-    tr_gui_module_t* module = &rack->gui_modules[rack->gui_module_count];
-    memset(module, 0, sizeof(tr_gui_module_t));
-    module->type = type;
+    tr_rack_reclaim_modules(rack);
+
+    tr_gui_module_t* module = NULL;
+    for (size_t i = 0; i < rack->gui_module_count; ++i)
+    {
+        if (rack->gui_modules[i].removed && rack->gui_modules[i].data == NULL)
+        {
+            module = &rack->gui_modules[i];
+            break;
+        }
+    }
 
-    //tr_module_pool_t* pool = &rack->module_pool[type];
-    //assert(pool->elements != NULL);
-    //const size_t module_data_index = pool->count++;
-    //module->data = tr_module_pool_get(pool, module_data_index);
+    // A reused slot stays flagged removed until it's complete, the engine
+    // skips it meanwhile and doesn't look at its type or data. pruned is left
+    // to the engine, the next schedule sets it.
+    const bool reused = module != NULL;
+    if (!reused)
+    {
+        assert(rack->gui_module_count < TR_GUI_MODULE_COUNT);
+        module = &rack->gui_modules[rack->gui_module_count];
+        memset(module, 0, sizeof(tr_gui_module_t));
+    }
+    module->type = type;
+    atomic_store_explicit(&module->released, false, memory_order_relaxed);
 
     const tr_module_info_t* module_info = &tr_module_infos[type];
+    assert(module_info->field_count <= TR_MODULE_FIELD_COUNT_MAX);
     module->data = tr_module_pool_alloc(&rack->module_pool, module_info->struct_size);
-    
-    for (size_t i = 0; i < module_info->field_count; ++i)
+    memset(module->data, 0, module_info->struct_size);
+    tr_module_vtable[type].init(module->data);
+
+    // silent until the next schedule gives the outputs their buffers
+    for (size_t field_index = 0; field_index < module_info->field_count; ++field_index)
     {
-        const tr_module_field_info_t* field_info = &module_info->fields[i];
-        switch (field_info->type)
+        if (module_info->fields[field_index].type == TR_MODULE_FIELD_BUFFER)
         {
-            case TR_MODULE_FIELD_INPUT_FLOAT:
-                memcpy(get_field_address(module, i), &field_info->default_value, sizeof(field_info->default_value));
-                break;
-            default: break;
+            *(float**)get_field_address(module, field_index) = g_buffer_pool[0];
         }
     }
+    if (type == TR_NOISE)
+    {
+        tr_noise_seed(module->data, tr_get_gui_module_index(rack, module));
+    }
+    if (type == TR_SCOPE)
+    {
+        module->scope_view = tr_rack_alloc_scope_view(rack);
+    }
 
-    ++rack->gui_module_count;
+    // The engine may compile a schedule while the UI adds a module, the slot
+    // has to be complete before it's counted.
+    if (reused)
+    {
+        atomic_store_explicit(&module->removed, false, memory_order_release);
+    }
+    else
+    {
+        atomic_fetch_add_explicit(&rack->gui_module_count, 1, memory_order_release);
+    }
     return module;
 }
 
+// Queues a command for the engine. Cable edits go to gui_cables as soon as
+// they're queued, the UI doesn't wait for the engine to apply them.
+bool tr_rack_push_command(rack_t* rack, tr_command_queue_t* queue, const tr_command_t* command)
+{
+    if (!tr_command_queue_push(queue, command))
+    {
+        return false;
+    }
+
+    switch (command->type)
+    {
+        case TR_COMMAND_CONNECT:
+            rack->gui_cables[command->module][command->field] = (tr_gui_cable_t){
+                .connected = true,
+                .color = command->source.color,
+                .source_module = command->source.module,
+                .source_field = command->source.field,
+            };
+            break;
+
+        case TR_COMMAND_DISCONNECT:
+            rack->gui_cables[command->module][command->field].connected = false;
+            break;
+
+        case TR_COMMAND_REMOVE_MODULE:
+            memset(rack->gui_cables[command->module], 0, sizeof(rack->gui_cables[0]));
+            for (size_t i = 0; i < rack->gui_module_count; ++i)
+            {
+                for (size_t field_index = 0; field_index < TR_MODULE_FIELD_COUNT_MAX; ++field_index)
+                {
+                    tr_gui_cable_t* cable = &rack->gui_cables[i][field_index];
+                    if (cable->source_module == command->module)
+                    {
+                        cable->connected = false;
+                    }
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+    return true;
+}
+
+// The module disappears from the UI right away, the engine disconnects it
+// when it applies the command. The flag is set first, so the schedule that
+// follows the command skips the module.
+bool tr_rack_remove_module(rack_t* rack, tr_command_queue_t* queue, tr_gui_module_t* module)
+{
+    atomic_store_explicit(&module->removed, true, memory_order_release);
+
+    const bool queued = tr_rack_push_command(rack, queue, &(tr_command_t){
+        .type = TR_COMMAND_REMOVE_MODULE,
+        .module = (uint16_t)tr_get_gui_module_index(rack, module),
+    });
+    if (!queued)
+    {
+        atomic_store_explicit(&module->removed, false, memory_order_release);
+    }
+    return queued;
+}
+
+// Topmost module under the position, they're drawn in rack order.
+tr_gui_module_t* tr_rack_module_at(rack_t* rack, float2 pos)
+{
+    for (size_t i = rack->gui_module_count; i > 0; --i)
+    {
+        tr_gui_module_t* module = &rack->gui_modules[i - 1];
+        if (module->removed)
+        {
+            continue;
+        }
+
+        const tr_module_info_t* module_info = &tr_module_infos[module->type];
+        if (pos.x > module->x &&
+            pos.y > module->y &&
+            pos.x < module->x + module_info->width &&
+            pos.y < module->y + module_info->height)
+        {
+            return module;
+        }
+    }
+    return NULL;
+}
+
 void rack_init(rack_t* rack)
 {
     memset(rack, 0, sizeof(rack_t));
-    rack->module_pool.data = g_module_pool_memory;
+    rack->module_pool.data = g_module_pool_memory[0];
+    rack->cable_count = 1;
 }
 
 typedef struct tr_cable_draw_command
@@ -234,7 +574,10 @@ static const float g_input_snap_radius[TR_INPUT_TYPE_COUNT] = {
 
 typedef struct tr_gui_input
 {
+    // The knob being turned. The module only sees the value once the engine
+    // applies the command, the knob draws from the shadow value meanwhile.
     void* active_value;
+    float active_float; // for float knob
     float active_int; // for int knob
 
     tr_gui_module_t* drag_module;
@@ -271,6 +614,11 @@ void tr_update_closest_input_state(tr_gui_input_t* state, const rack_t* rack, fl
     for (size_t module_index = 0; module_index < rack->gui_module_count; ++module_index)
     {
         const tr_gui_module_t* module = &rack->gui_modules[module_index];
+        if (module->removed)
+        {
+            continue;
+        }
+
         const tr_module_info_t* module_info = &tr_module_infos[module->type];
         for (size_t i = 0; i < module_info->field_count; ++i)
         {
@@ -382,9 +730,10 @@ typedef struct app
     size_t recording_offset;
 #endif
 
-    float final_mix[TR_SAMPLE_COUNT];
-    size_t final_mix_remaining;
-    bool has_audio_callback_been_called_once;
+    tr_command_queue_t commands; // UI -> engine, see tr_rack_apply_commands
+
+    atomic_bool is_audio_running; // the worklet consumes the ring, see tr_audio_render
+    atomic_bool is_engine_running; // the engine worker owns the rack, see tr_engine_run
 
     bool picker_mode;
     bool paused;
@@ -431,36 +780,19 @@ void tr_serialize_input_int(tr_strbuf_t* sb, const char* name, int value)
     sb_append_cstring(sb, "\n");
 }
 
-void tr_serialize_input_buffer(tr_strbuf_t* sb, const rack_t* rack, const char* name, const float** value)
+// patch_indices maps the rack slots to the module indices of the patch,
+// which has no holes for the removed modules.
+void tr_serialize_input_buffer(tr_strbuf_t* sb, const rack_t* rack, const uint16_t* patch_indices, const char* name, const tr_gui_cable_t* cable)
 {
-    const float* buffer = *value;
-    if (buffer == NULL)
+    const tr_gui_module_t* source = &rack->gui_modules[cable->source_module];
+    if (source->removed)
     {
         return;
     }
 
-    const int plug_idx = tr_hmget(rack->output_plugs_key, buffer);
-    assert(plug_idx != -1);
-    const tr_output_plug_t* plug = &rack->output_plugs[plug_idx];
-
-    const size_t module_index = tr_get_gui_module_index(rack, plug->module);
-
-    const tr_module_info_t* module_info = &tr_module_infos[plug->module->type];
-
-    //const void* module_addr = tr_get_module_address(ctx->rack, plug->module->type, plug->module->index);
-    const uintptr_t field_offset = (uintptr_t)buffer - (uintptr_t)plug->module->data;
-    
-    const tr_module_field_info_t* field_info = NULL;
-
-    for (int i = 0; i < module_info->field_count; ++i)
-    {
-        if (field_offset == module_info->fields[i].offset)
-        {
-            field_info = &module_info->fields[i];
-            break;
-        }
-    }
-    assert(field_info != NULL);
+    const size_t module_index = patch_indices[cable->source_module];
+    const tr_module_info_t* module_info = &tr_module_infos[source->type];
+    const tr_module_field_info_t* field_info = &module_info->fields[cable->source_field];
     assert(field_info->type == TR_MODULE_FIELD_BUFFER);
 
     sb_append_cstring(sb, "input_buffer ");
@@ -476,15 +808,28 @@ void tr_serialize_input_buffer(tr_strbuf_t* sb, const rack_t* rack, const char*
 
 int tr_rack_serialize(tr_strbuf_t* sb, rack_t* rack)
 {
+    static uint16_t patch_indices[TR_GUI_MODULE_COUNT];
+    uint16_t patch_module_count = 0;
+    for (size_t i = 0; i < rack->gui_module_count; ++i)
+    {
+        patch_indices[i] = patch_module_count;
+        patch_module_count += !rack->gui_modules[i].removed;
+    }
+
     for (size_t i = 0; i < rack->gui_module_count; ++i)
     {
         const tr_gui_module_t* module = &rack->gui_modules[i];
+        if (module->removed)
+        {
+            continue;
+        }
+
         const char* name = tr_module_infos[module->type].id;
         
         sb_append_cstring(sb, "module ");
         sb_append_cstring(sb, name);
         sb_append_cstring(sb, " ");
-        sb_append_int(sb, (int)i);
+        sb_append_int(sb, (int)patch_indices[i]);
         sb_append_cstring(sb, " pos ");
         sb_append_int(sb, (int)module->x);
         sb_append_cstring(sb, " ");
@@ -517,8 +862,11 @@ int tr_rack_serialize(tr_strbuf_t* sb, rack_t* rack)
 
                 case TR_MODULE_FIELD_INPUT_BUFFER:
                 {
-                    const float** value = (const float**)((uint8_t*)module_addr + field_info->offset);
-                    tr_serialize_input_buffer(sb, rack, field_info->name, value);
+                    const tr_gui_cable_t* cable = &rack->gui_cables[i][field_index];
+                    if (cable->connected)
+                    {
+                        tr_serialize_input_buffer(sb, rack, patch_indices, field_info->name, cable);
+                    }
                     break;
                 }
 
@@ -548,18 +896,6 @@ void tr_rack_deserialize(rack_t* rack, const char* input, size_t len)
         tr_gui_module_t* module = tr_rack_create_module(rack, cmd->type);
         module->x = cmd->x;
         module->y = cmd->y;
-
-        const tr_module_info_t* module_info = &tr_module_infos[module->type];
-        for (size_t field_index = 0; field_index < module_info->field_count; ++field_index)
-        {
-            const tr_module_field_info_t* field_info = &module_info->fields[field_index];
-            if (field_info->type == TR_MODULE_FIELD_BUFFER)
-            {
-                float* field_addr = get_field_address(module, field_index);
-                const int output_plug_idx = tr_hmput(rack->output_plugs_key, field_addr);
-                rack->output_plugs[output_plug_idx] = (tr_output_plug_t){module, field_info};
-            }
-        }
     }
 
     for (size_t i = 0; i < parser.value_count; ++i)
@@ -576,15 +912,26 @@ void tr_rack_deserialize(rack_t* rack, const char* input, size_t len)
                 memcpy(field_addr, &cmd->value, cmd->value_size);
                 break;
             case TR_SET_VALUE_BUFFER:
+            {
                 //printf("SET BUFFER: %zu:%zu = %zu:%zu\n", cmd->module_index, cmd->field_offset, cmd->target_module_index, cmd->target_field_offset);
-                const tr_gui_module_t* target_module = &rack->gui_modules[cmd->target_module_index];
-                void* target_field_addr = (uint8_t*)target_module->data + cmd->target_field_offset;
-                //*(float**)field_addr = (float*)target_field_addr;
-                memcpy(field_addr, &target_field_addr, sizeof(void*));
-
-                const int input_plug_idx = tr_hmput(rack->input_plugs_key, field_addr);
-                rack->input_plugs[input_plug_idx] = (tr_input_plug_t){tr_random_cable_color()};
+                // the engine doesn't run yet, both tables are set here
+                const tr_cable_t cable = {
+                    .color = tr_random_cable_color(),
+                    .source_module = (uint16_t)cmd->target_module_index,
+                    .source_field = (uint16_t)cmd->target_field_index,
+                    .target_module = (uint16_t)cmd->module_index,
+                    .target_field = (uint16_t)cmd->field_index,
+                };
+                tr_rack_connect(rack, cable);
+                rack->gui_cables[cable.target_module][cable.target_field] = (tr_gui_cable_t){
+                    .connected = true,
+                    .color = cable.color,
+                    .source_module = cable.source_module,
+                    .source_field = cable.source_field,
+                };
+                tr_rack_invalidate_schedule(rack);
                 break;
+            }
         }
     }
 
@@ -622,7 +969,7 @@ void tr_gui_module_begin(tr_gui_module_t* module)
     draw_rectangle_rounded(
         bgrect, 
         0.2f,
-        COLOR_MODULE_BACKGROUND);
+        atomic_load_explicit(&module->pruned, memory_order_relaxed) ? COLOR_MODULE_BACKGROUND_PRUNED : COLOR_MODULE_BACKGROUND);
 
     const char* name = tr_module_infos[module->type].id;
     const float fontsize = 22;
@@ -717,19 +1064,34 @@ void tr_gui_knob_float(const tr_gui_module_t* module, size_t field_index)
             if (float2_distance(mouse, center) < TR_KNOB_RADIUS)
             {
                 g_input.active_value = value;
+                g_input.active_float = *value;
             }
         }
         
         if (g_input.active_value == value)
         {
             const float range = (max - min);
-            *value -= get_mouse_delta().y * range * 0.01f;
-            if (*value < min) *value = min;
-            if (*value > max) *value = max;
+            float new_value = g_input.active_float - get_mouse_delta().y * range * 0.01f;
+            if (new_value < min) new_value = min;
+            if (new_value > max) new_value = max;
+
+            // When the queue is full the knob stays where the engine has it,
+            // the next mouse move tries again.
+            if (new_value != g_input.active_float &&
+                tr_command_queue_push(&g_app.commands, &(tr_command_t){
+                    .type = TR_COMMAND_SET_FLOAT,
+                    .module = (uint16_t)tr_get_gui_module_index(&g_app.rack, module),
+                    .field = (uint16_t)field_index,
+                    .float_value = new_value,
+                }))
+            {
+                g_input.active_float = new_value;
+            }
         }
     }
 
-    tr_gui_knob_base(*value, min, max, x, y, highlight);
+    const float display_value = g_input.active_value == value ? g_input.active_float : *value;
+    tr_gui_knob_base(display_value, min, max, x, y, highlight);
 }
 
 void tr_gui_knob_int(const tr_gui_module_t* module, size_t field_index)
@@ -776,16 +1138,31 @@ void tr_gui_knob_int(const tr_gui_module_t* module, size_t field_index)
             }
         }
         
+        int display_value = *value;
         if (g_input.active_value == value)
         {
+            const float prev_active_int = g_input.active_int;
+            const int prev_value = (int)tr_roundf(g_input.active_int);
             g_input.active_int -= get_mouse_delta().y * (max - min) * 0.01f;
-
-            *value = (int)tr_roundf(g_input.active_int);
-            if (*value < min) *value = min;
-            if (*value > max) *value = max;
+            if (g_input.active_int < min) g_input.active_int = (float)min;
+            if (g_input.active_int > max) g_input.active_int = (float)max;
+
+            display_value = (int)tr_roundf(g_input.active_int);
+            // same as the float knob, a full queue drops the move
+            if (display_value != prev_value &&
+                !tr_command_queue_push(&g_app.commands, &(tr_command_t){
+                    .type = TR_COMMAND_SET_INT,
+                    .module = (uint16_t)tr_get_gui_module_index(&g_app.rack, module),
+                    .field = (uint16_t)field_index,
+                    .int_value = display_value,
+                }))
+            {
+                g_input.active_int = prev_active_int;
+                display_value = prev_value;
+            }
         }
 
-        tr_gui_knob_base((float)*value, (float)min, (float)max, x, y, highlight);
+        tr_gui_knob_base((float)display_value, (float)min, (float)max, x, y, highlight);
     }
 }
 
@@ -824,18 +1201,20 @@ static void tr_gui_plug_input(rack_t* rack, const tr_gui_module_t* module, size_
         .color = COLOR_PLUG_HOLE,
     };
     
-    if (*value != NULL)
+    const tr_gui_cable_t* cable = &rack->gui_cables[tr_get_gui_module_index(rack, module)][field_index];
+    if (cable->connected)
     {
-        const int output_plug_idx = tr_hmget(rack->output_plugs_key, *value);
-        const tr_output_plug_t* output_plug = &rack->output_plugs[output_plug_idx];
-        const int input_plug_idx = tr_hmget(rack->input_plugs_key, value);
-        const tr_input_plug_t* input_plug = &rack->input_plugs[input_plug_idx];
+        const tr_gui_module_t* source = &rack->gui_modules[cable->source_module];
 
-        g_input.cable_draws[g_input.cable_draw_count++] = (tr_cable_draw_command_t){
-            .from = center,
-            .to = {output_plug->module->x + output_plug->field->x, output_plug->module->y + output_plug->field->y},
-            .color = input_plug->color,
-        };
+        if (!source->removed)
+        {
+            const tr_module_field_info_t* source_field = &tr_module_infos[source->type].fields[cable->source_field];
+            g_input.cable_draws[g_input.cable_draw_count++] = (tr_cable_draw_command_t){
+                .from = center,
+                .to = {source->x + source_field->x, source->y + source_field->y},
+                .color = cable->color,
+            };
+        }
     }
 
     const float2 mouse = get_screen_to_world(get_mouse_position(), g_input.camera);
@@ -956,6 +1335,21 @@ void tr_quantizer_decorate(tr_quantizer_t* quantizer, tr_gui_module_t* module)
     draw_text(FONT_BERKELY_MONO, g_tr_quantizer_mode_name[quantizer->in_mode], (float2){kx + TR_KNOB_RADIUS + 8, y + 40}, 20, 0, COLOR_MODULE_TEXT);
 }
 
+static const char* g_tr_wavetable_shape_name[] = {
+    "sine",
+    "triangle",
+    "saw",
+    "square",
+};
+
+void tr_wavetable_decorate(tr_wavetable_t* wavetable, tr_gui_module_t* module)
+{
+    const float x = module->x;
+    const float y = module->y;
+    const float kx = x + 24.0f;
+    draw_text(FONT_BERKELY_MONO, g_tr_wavetable_shape_name[wavetable->in_shape], (float2){kx + TR_KNOB_RADIUS + 8, y + 40}, 20, 0, COLOR_MODULE_TEXT);
+}
+
 void tr_scope_decorate(tr_scope_t* scope, tr_gui_module_t* module)
 {
     const float screen_x = module->x + 8;
@@ -968,13 +1362,28 @@ void tr_scope_decorate(tr_scope_t* scope, tr_gui_module_t* module)
         .color = {0, 0, 0, 255},
     }; 
 
-    if (scope->in_0 != NULL)
+    // scope->in_0 belongs to the engine, draw the last block it published
+    (void)scope;
+    if (module->scope_view == 0)
+    {
+        return;
+    }
+
+    tr_scope_view_t* view = &g_scope_views[module->scope_view - 1];
+    if (atomic_load_explicit(&view->middle, memory_order_relaxed) & TR_SCOPE_VIEW_FRESH)
+    {
+        const unsigned middle = atomic_exchange_explicit(&view->middle, view->front, memory_order_acq_rel);
+        view->front = middle & ~TR_SCOPE_VIEW_FRESH;
+    }
+
+    if (view->connected[view->front])
     {
+        const float* samples = view->samples[view->front];
         float2* vertices = rb_draw_line_strip(&g_rb, TR_SAMPLE_COUNT, (color_t){255, 255, 0, 255});
 
         for (int i = 0; i < TR_SAMPLE_COUNT; ++i)
         {
-            const float s0 = scope->in_0[i];
+            const float s0 = samples[i];
             const float x0 = float_remap(i + 0.0f, 0.0f, (float)TR_SAMPLE_COUNT, (float)screen_x, (float)screen_x + screen_w);
             const float y0 = float_remap(s0, -1.0f, 1.0f, (float)screen_y + screen_h, (float)screen_y);
             
@@ -1001,226 +1410,379 @@ void tr_gui_module_draw(rack_t* rack, tr_gui_module_t* module)
         }
     }
 
-    switch (module->type)
+    const tr_module_decorate_fn decorate = tr_module_vtable[module->type].decorate;
+    if (decorate != NULL)
     {
-        case TR_CLOCK: tr_clock_decorate(module->data, module); break;
-        case TR_CLOCKDIV: tr_clockdiv_decorate(module->data, module); break;
-        case TR_SEQ8: tr_seq8_decorate(module->data, module); break;
-        case TR_QUANTIZER: tr_quantizer_decorate(module->data, module); break;
-        case TR_SCOPE: tr_scope_decorate(module->data, module); break;
-        default: break;
+        decorate(module->data, module);
     }
 
     tr_gui_module_end();
 }
 
-void tr_update_modules(tr_gui_module_t** modules, size_t count)
+void tr_update_modules(const tr_schedule_t* schedule)
 {
 #if TR_TRACE_MODULE_UPDATES
     printf("tr_update_modules:\n");
 #endif
 
-    for (size_t i = 0; i < count; ++i)
+    const tr_schedule_entry_t* entries = schedule->entries;
+    for (size_t i = 0; i < schedule->entry_count; ++i)
     {
-        tr_gui_module_t* module = modules[i];
-
-        switch (module->type)
-        {
-            case TR_VCO: tr_vco_update(module->data); break;
-            case TR_CLOCK: tr_clock_update(module->data); break;
-            case TR_CLOCKDIV: tr_clockdiv_update(module->data); break;
-            case TR_SEQ8: tr_seq8_update(module->data); break;
-            case TR_ADSR: tr_adsr_update(module->data); break;
-            case TR_VCA: tr_vca_update(module->data); break;
-            case TR_LP: tr_lp_update(module->data); break;
-            case TR_MIXER: tr_mixer_update(module->data); break;
-            case TR_NOISE: tr_noise_update(module->data); break;
-            case TR_QUANTIZER: tr_quantizer_update(module->data); break;
-            case TR_RANDOM: tr_random_update(module->data); break;
-            default: break;
-        }
+        entries[i].update(entries[i].data);
 
 #if TR_TRACE_MODULE_UPDATES
-        printf("\t%s %zu\n", tr_module_infos[module->type].id, module->index);
+        printf("\t%p\n", entries[i].data);
 #endif
     }
 }
 
-int tr_enumerate_inputs(const float* inputs[], const tr_gui_module_t* module)
+typedef struct tr_module_graph_frame
 {
-    int count = 0;
+    uint16_t module;
+    uint16_t edge; // next edge to visit
+} tr_module_graph_frame_t;
 
-    const tr_module_info_t* module_info = &tr_module_infos[module->type];
+// Scratch space for tr_resolve_module_graph. Too big for the wasm stack.
+typedef struct tr_module_graph
+{
+    // consumers of each module, in compressed sparse row form
+    uint16_t edge_offset[TR_GUI_MODULE_COUNT + 1];
+    uint16_t edges[TR_MAX_CABLES];
+
+    // Tarjan state
+    int32_t index[TR_GUI_MODULE_COUNT];
+    int32_t lowlink[TR_GUI_MODULE_COUNT];
+    bool on_stack[TR_GUI_MODULE_COUNT];
+    uint16_t stack[TR_GUI_MODULE_COUNT];
+    tr_module_graph_frame_t call_stack[TR_GUI_MODULE_COUNT];
+
+    // components in the order Tarjan emits them (consumers before producers)
+    uint16_t component_modules[TR_GUI_MODULE_COUNT];
+    uint16_t component_offset[TR_GUI_MODULE_COUNT + 1];
+    size_t component_count;
+
+    bool live[TR_GUI_MODULE_COUNT];
+    uint16_t order_position[TR_GUI_MODULE_COUNT]; // UINT16_MAX for pruned and removed modules
+
+    // level assignment, indexed by order position
+    uint16_t level[TR_GUI_MODULE_COUNT];
+    uint16_t level_start[TR_GUI_MODULE_COUNT + 1];
+    tr_gui_module_t* sorted[TR_GUI_MODULE_COUNT];
+} tr_module_graph_t;
+
+static tr_module_graph_t g_module_graph;
+
+static void tr_module_graph_build_edges(tr_module_graph_t* graph, const rack_t* rack)
+{
+    const size_t module_count = rack->gui_module_count;
+
+    memset(graph->edge_offset, 0, sizeof(graph->edge_offset));
 
-    for (size_t i = 0; i < module_info->field_count; ++i)
+    for (size_t i = 0; i < module_count; ++i)
     {
-        const tr_module_field_info_t* field = &module_info->fields[i];
-        if (field->type == TR_MODULE_FIELD_INPUT_BUFFER)
+        for (uint16_t c = tr_rack_first_input_cable(rack, i); c != 0; c = rack->cables[c].next_input)
         {
-            inputs[count++] = *(float**)((uint8_t*)module->data + field->offset);
+            ++graph->edge_offset[rack->cables[c].source_module + 1];
         }
     }
 
-    return count;
-}
+    for (size_t i = 0; i < module_count; ++i)
+    {
+        graph->edge_offset[i + 1] += graph->edge_offset[i];
+    }
 
-typedef struct tr_module_sort_data
-{
-    uint32_t module_index;
-    int distance;
-} tr_module_sort_data_t;
+    // edge_offset[i] is used as the write cursor and shifted back afterwards
+    for (size_t i = 0; i < module_count; ++i)
+    {
+        for (uint16_t c = tr_rack_first_input_cable(rack, i); c != 0; c = rack->cables[c].next_input)
+        {
+            graph->edges[graph->edge_offset[rack->cables[c].source_module]++] = (uint16_t)i;
+        }
+    }
+
+    for (size_t i = module_count; i > 0; --i)
+    {
+        graph->edge_offset[i] = graph->edge_offset[i - 1];
+    }
+    graph->edge_offset[0] = 0;
+}
 
-static int tr_update_module_sort_function(const void* lhs, const void* rhs)
+static bool tr_module_is_sink(enum tr_module_type type)
 {
-    return ((const tr_module_sort_data_t*)rhs)->distance - ((const tr_module_sort_data_t*)lhs)->distance;
+    return type == TR_SPEAKER || type == TR_SCOPE;
 }
 
-size_t tr_collect_leaf_modules(rack_t* rack, const tr_gui_module_t* leaf_modules[])
+// A module is live if it's a sink or feeds a live module. Tarjan emits
+// consumers first, so every component only has to look at components that
+// are already resolved. All members of a component share the result since
+// they can reach each other.
+static void tr_module_graph_mark_live(tr_module_graph_t* graph, const rack_t* rack)
 {
-    uint32_t output_mask[TR_GUI_MODULE_COUNT / 32];
-    memset(output_mask, 0, sizeof(output_mask));
-    
-    for (size_t i = 0; i < rack->gui_module_count; ++i)
+    for (size_t c = 0; c < graph->component_count; ++c)
     {
-        const float* inputs[64];
-        const int input_count = tr_enumerate_inputs(inputs, &rack->gui_modules[i]);
+        const size_t first = graph->component_offset[c];
+        const size_t last = graph->component_offset[c + 1];
 
-        for (int input_index = 0; input_index < input_count; ++input_index)
+        for (size_t i = first; i < last; ++i)
         {
-            if (inputs[input_index] == NULL)
-            {
-                continue;
-            }
+            graph->live[graph->component_modules[i]] = false;
+        }
 
-            const int output_plug_idx = tr_hmget(rack->output_plugs_key, inputs[input_index]);
-            const tr_output_plug_t* output_plug = &rack->output_plugs[output_plug_idx];
-            
-            const size_t module_index = tr_get_gui_module_index(rack, output_plug->module);
-            output_mask[module_index / 32] |= 1 << (module_index % 32);
+        bool live = false;
+        for (size_t i = first; i < last && !live; ++i)
+        {
+            const uint16_t v = graph->component_modules[i];
+            if (!rack->gui_modules[v].removed && tr_module_is_sink(rack->gui_modules[v].type))
+            {
+                live = true;
+                break;
+            }
+
+            for (size_t e = graph->edge_offset[v]; e < graph->edge_offset[v + 1]; ++e)
+            {
+                if (graph->live[graph->edges[e]])
+                {
+                    live = true;
+                    break;
+                }
+            }
+        }
+
+        for (size_t i = first; i < last; ++i)
+        {
+            graph->live[graph->component_modules[i]] = live;
         }
     }
+}
 
-    size_t count = 0;
-    for (size_t i = 0; i < rack->gui_module_count; ++i)
+// Level of a module: one more than the level of everything it has to run
+// after. That's its producers, except feedback ones, plus the consumers
+// reading it through a feedback cable, they must see last block's output
+// before it gets overwritten. update_modules is then sorted by level, which
+// keeps every dependency of the single-threaded order.
+static void tr_module_graph_assign_levels(tr_module_graph_t* graph, tr_gui_module_t** update_modules, uint16_t* update_levels, size_t update_count, rack_t* rack)
+{
+    size_t level_count = 0;
+
+    for (size_t p = 0; p < update_count; ++p)
     {
-        if (output_mask[i / 32] & (1 << (i % 32)))
+        tr_gui_module_t* module = update_modules[p];
+        const size_t module_index = module - rack->gui_modules;
+        uint16_t level = 0;
+
+        for (uint16_t c = tr_rack_first_input_cable(rack, module_index); c != 0; c = rack->cables[c].next_input)
         {
-            continue;
+            const uint16_t source_position = graph->order_position[rack->cables[c].source_module];
+            if (source_position < p && graph->level[source_position] + 1 > level)
+            {
+                level = graph->level[source_position] + 1;
+            }
         }
 
-        leaf_modules[count++] = &rack->gui_modules[i];
+        for (size_t e = graph->edge_offset[module_index]; e < graph->edge_offset[module_index + 1]; ++e)
+        {
+            const uint16_t consumer_position = graph->order_position[graph->edges[e]];
+            if (consumer_position < p && graph->level[consumer_position] + 1 > level)
+            {
+                level = graph->level[consumer_position] + 1;
+            }
+        }
+
+        graph->level[p] = level;
+        if (level + 1u > level_count)
+        {
+            level_count = level + 1u;
+        }
     }
 
-    return count;
+    memset(graph->level_start, 0, sizeof(graph->level_start[0]) * (level_count + 1));
+    for (size_t p = 0; p < update_count; ++p)
+    {
+        graph->level_start[graph->level[p] + 1]++;
+    }
+    for (size_t l = 0; l < level_count; ++l)
+    {
+        graph->level_start[l + 1] += graph->level_start[l];
+    }
+    for (size_t p = 0; p < update_count; ++p)
+    {
+        const uint16_t slot = graph->level_start[graph->level[p]]++;
+        graph->sorted[slot] = update_modules[p];
+        update_levels[slot] = graph->level[p];
+    }
+
+    memcpy(update_modules, graph->sorted, sizeof(update_modules[0]) * update_count);
 }
 
-size_t tr_resolve_module_graph(tr_gui_module_t** update_modules, rack_t* rack)
+static void tr_module_graph_emit_component(tr_module_graph_t* graph, int* sp, uint16_t root, size_t* emitted)
 {
-    tb_start(&g_app.tb_resolve_module_graph);
-
-    const tr_gui_module_t* leaf_modules[TR_GUI_MODULE_COUNT];
-    const size_t leaf_count = tr_collect_leaf_modules(rack, leaf_modules);
-
-    typedef struct stack_item
+    const size_t first = *emitted;
+    uint16_t w;
+    do
     {
-        const tr_gui_module_t* module;
-        const tr_gui_module_t* parent;
-    } stack_item_t;
-    
-    stack_item_t stack[TR_GUI_MODULE_COUNT];
-    int sp = 0;
+        w = graph->stack[--(*sp)];
+        graph->on_stack[w] = false;
+
+        // insertion sort by rack index, components are usually tiny
+        size_t j = (*emitted)++;
+        while (j > first && graph->component_modules[j - 1] > w)
+        {
+            graph->component_modules[j] = graph->component_modules[j - 1];
+            --j;
+        }
+        graph->component_modules[j] = w;
+    } while (w != root);
 
-    uint32_t distance[TR_GUI_MODULE_COUNT];
-    memset(distance, 0, sizeof(distance));
+    graph->component_offset[++graph->component_count] = (uint16_t)*emitted;
+}
 
-    for (size_t leaf_index = 0; leaf_index < leaf_count; ++leaf_index)
+static void tr_module_graph_tarjan(tr_module_graph_t* graph, size_t module_count)
+{
+    for (size_t i = 0; i < module_count; ++i)
     {
-        const tr_gui_module_t* leaf_module = leaf_modules[leaf_index];
-        assert(distance[tr_get_gui_module_index(rack, leaf_module)] == 0);
+        graph->index[i] = -1;
+        graph->on_stack[i] = false;
+    }
 
-        assert(sp == 0);
-        stack[sp++] = (stack_item_t){leaf_module};
+    int32_t next_index = 0;
+    int sp = 0;
+    size_t emitted = 0;
+    graph->component_count = 0;
+    graph->component_offset[0] = 0;
 
-        uint32_t visited_mask[TR_GUI_MODULE_COUNT / 32];
-        memset(visited_mask, 0, sizeof(visited_mask));
+    for (size_t root = 0; root < module_count; ++root)
+    {
+        if (graph->index[root] != -1)
+        {
+            continue;
+        }
 
-#if TR_TRACE_MODULE_GRAPH
-        printf("leaf %zu:\n", leaf_index);
-#endif
+        int csp = 0;
+        graph->call_stack[csp++] = (tr_module_graph_frame_t){(uint16_t)root, graph->edge_offset[root]};
+        graph->index[root] = graph->lowlink[root] = next_index++;
+        graph->stack[sp++] = (uint16_t)root;
+        graph->on_stack[root] = true;
 
-        while (sp > 0)
+        while (csp > 0)
         {
-            const stack_item_t top = stack[--sp];
-            const size_t module_index = tr_get_gui_module_index(rack, top.module);
+            const uint16_t v = graph->call_stack[csp - 1].module;
+            const uint16_t e = graph->call_stack[csp - 1].edge;
 
-            if (top.parent != NULL)
+            if (e < graph->edge_offset[v + 1])
             {
-#if TR_TRACE_MODULE_GRAPH
-                printf("\t(%s %zu) <- (%s %zu)\n", 
-                    tr_module_infos[top.module->type].id, top.module->index,
-                    tr_module_infos[top.parent->type].id, top.parent->index);
-#endif
-
-                const size_t parent_module_index = tr_get_gui_module_index(rack, top.parent);
-                assert(visited_mask[parent_module_index / 32] & (1 << (parent_module_index % 32)));
-                const uint32_t next_distance = distance[parent_module_index] + 1;
-                if (distance[module_index] < next_distance)
+                ++graph->call_stack[csp - 1].edge;
+                const uint16_t w = graph->edges[e];
+                if (graph->index[w] == -1)
                 {
-#if TR_TRACE_MODULE_GRAPH
-                    printf("\t\t[%u -> %u]\n", distance[module_index], next_distance);
-#endif
-                    distance[module_index] = next_distance;
+                    graph->index[w] = graph->lowlink[w] = next_index++;
+                    graph->stack[sp++] = w;
+                    graph->on_stack[w] = true;
+                    graph->call_stack[csp++] = (tr_module_graph_frame_t){w, graph->edge_offset[w]};
                 }
+                else if (graph->on_stack[w] && graph->index[w] < graph->lowlink[v])
+                {
+                    graph->lowlink[v] = graph->index[w];
+                }
+                continue;
             }
-            else
+
+            if (graph->lowlink[v] == graph->index[v])
             {
-#if TR_TRACE_MODULE_GRAPH
-                printf("\t(%s %zu)\n", tr_module_infos[top.module->type].id, top.module->index);
-#endif
+                tr_module_graph_emit_component(graph, &sp, v, &emitted);
             }
 
-            if (visited_mask[module_index / 32] & (1 << (module_index % 32)))
+            --csp;
+            if (csp > 0)
             {
-                continue;
+                const uint16_t parent = graph->call_stack[csp - 1].module;
+                if (graph->lowlink[v] < graph->lowlink[parent])
+                {
+                    graph->lowlink[parent] = graph->lowlink[v];
+                }
             }
+        }
+    }
 
-            visited_mask[module_index / 32] |= (1 << (module_index % 32));
+    assert(emitted == module_count);
+}
 
-            const float* inputs[64];
-            const int input_count = tr_enumerate_inputs(inputs, top.module);
+// Computes the module update order in O(modules + cables).
+//
+// Cables are edges from the module that owns the output to the module that
+// owns the input. Tarjan's algorithm splits the graph into strongly connected
+// components and emits them with consumers before producers, so walking the
+// components backwards updates every module after everything it reads from.
+//
+// A component with more than one module (or a module patched into itself) is
+// a feedback loop. Its members are updated in rack order, and every cable that
+// points backwards in the final order is a feedback cable: the consumer reads
+// the output its producer wrote during the previous block. Those cables are
+// flagged on their input plug.
+//
+// Modules that have no path to a speaker or scope are pruned: they're left
+// out of the order and flagged so the GUI can show them as inactive.
+//
+// The order is finally grouped by level, update_levels receives the level of
+// each module (see tr_module_graph_assign_levels).
+size_t tr_resolve_module_graph(tr_gui_module_t** update_modules, uint16_t* update_levels, rack_t* rack)
+{
+    tr_module_graph_t* graph = &g_module_graph;
+    const size_t module_count = rack->gui_module_count;
 
-            for (int i = 0; i < input_count; ++i)
-            {
-                if (inputs[i] == NULL)
-                {
-                    continue;
-                }
+    tr_module_graph_build_edges(graph, rack);
+    tr_module_graph_tarjan(graph, module_count);
+    tr_module_graph_mark_live(graph, rack);
 
-                const int output_plug_idx = tr_hmget(rack->output_plugs_key, inputs[i]);
-                const tr_output_plug_t* output_plug = &rack->output_plugs[output_plug_idx];
+    // positions of the previous schedule would outlive the modules pruned
+    // or removed since
+    memset(graph->order_position, 0xff, sizeof(graph->order_position[0]) * module_count);
 
-                assert(sp < tr_countof(stack));
-                stack[sp++] = (stack_item_t){output_plug->module, top.module};
+    size_t update_count = 0;
+    for (size_t c = graph->component_count; c > 0; --c)
+    {
+        for (size_t i = graph->component_offset[c - 1]; i < graph->component_offset[c]; ++i)
+        {
+            const uint16_t module_index = graph->component_modules[i];
+            tr_gui_module_t* module = &rack->gui_modules[module_index];
+
+            const bool pruned = !graph->live[module_index] || module->removed;
+            atomic_store_explicit(&module->pruned, pruned, memory_order_relaxed);
+            if (pruned)
+            {
+                continue;
             }
+
+            graph->order_position[module_index] = (uint16_t)update_count;
+            update_modules[update_count++] = module;
         }
     }
 
-    tr_module_sort_data_t sort_data[TR_GUI_MODULE_COUNT];
-
-    for (size_t i = 0; i < rack->gui_module_count; ++i)
+    for (size_t i = 0; i < module_count; ++i)
     {
-        sort_data[i] = (tr_module_sort_data_t){(uint32_t)i, distance[i]};
-    }
+        if (rack->gui_modules[i].pruned)
+        {
+            continue;
+        }
 
-    qsort(sort_data, rack->gui_module_count, sizeof(tr_module_sort_data_t), tr_update_module_sort_function);
+        for (uint16_t c = tr_rack_first_input_cable(rack, i); c != 0; c = rack->cables[c].next_input)
+        {
+            tr_cable_t* cable = &rack->cables[c];
+            const size_t source_index = cable->source_module;
+            const uint16_t source_position = graph->order_position[source_index];
+            const bool feedback = source_position != UINT16_MAX && source_position >= graph->order_position[i];
+            cable->feedback = feedback;
 
-    size_t update_count = 0;
-    for (size_t i = 0; i < rack->gui_module_count; ++i)
-    {
-        update_modules[update_count++] = &rack->gui_modules[sort_data[i].module_index];
+#if TR_TRACE_MODULE_GRAPH
+            printf("\t(%s %zu) -> (%s %zu)%s\n",
+                tr_module_infos[rack->gui_modules[source_index].type].id, source_index,
+                tr_module_infos[rack->gui_modules[i].type].id, i,
+                feedback ? " [feedback]" : "");
+#endif
+        }
     }
 
-    tb_stop(&g_app.tb_resolve_module_graph);
+    tr_module_graph_assign_levels(graph, update_modules, update_levels, update_count, rack);
+
     return update_count;
 }
 
@@ -1240,7 +1802,7 @@ static const tr_speaker_t* tr_find_speaker(rack_t* rack)
     for (size_t i = 0; i < rack->gui_module_count; ++i)
     {
         const tr_gui_module_t* module = &rack->gui_modules[i];
-        if (module->type != TR_SPEAKER)
+        if (module->removed || module->type != TR_SPEAKER)
         {
             continue;
         }
@@ -1258,13 +1820,482 @@ static const tr_speaker_t* tr_find_speaker(rack_t* rack)
     return speaker;
 }
 
+static void tr_schedule_batch_update(void* data)
+{
+    tr_schedule_batch_t* batch = data;
+    batch->update(batch->modules, batch->count);
+}
+
+// Adds the module to a batch of the current level that isn't full yet, or
+// starts a new one. Modules of a level don't depend on each other, so they
+// can be regrouped freely.
+static void tr_schedule_add_batched(tr_schedule_t* schedule, size_t level_first_batch, tr_module_batch_fn update, void* data)
+{
+    for (size_t i = level_first_batch; i < schedule->batch_count; ++i)
+    {
+        tr_schedule_batch_t* batch = &schedule->batches[i];
+        if (batch->update == update && batch->count < TR_SCHEDULE_BATCH_WIDTH)
+        {
+            batch->modules[batch->count++] = data;
+            return;
+        }
+    }
+
+    tr_schedule_batch_t* batch = &schedule->batches[schedule->batch_count++];
+    batch->update = update;
+    batch->count = 1;
+    batch->modules[0] = data;
+    schedule->entries[schedule->entry_count++] = (tr_schedule_entry_t){tr_schedule_batch_update, batch};
+}
+
+#define TR_MAX_MODULE_FIELDS (TR_GUI_MODULE_COUNT * 32)
+#define TR_BUFFER_PERSISTENT INT32_MAX
+
+// Scratch space for tr_assign_buffers
+typedef struct tr_buffer_liveness
+{
+    uint32_t field_offset[TR_GUI_MODULE_COUNT]; // first entry of each module in last_use
+    int32_t last_use[TR_MAX_MODULE_FIELDS]; // last level reading each field, -1 when nothing does
+    uint16_t free_buffers[TR_BUFFER_POOL_COUNT]; // stack, the top was freed last
+    size_t free_count;
+    uint16_t active_buffers[TR_BUFFER_POOL_COUNT];
+    int32_t active_last_use[TR_BUFFER_POOL_COUNT];
+    size_t active_count;
+} tr_buffer_liveness_t;
+
+static tr_buffer_liveness_t g_buffer_liveness;
+
+// Gives back the buffers whose last reader ran before the level.
+static void tr_buffer_liveness_release(tr_buffer_liveness_t* liveness, int32_t level)
+{
+    for (size_t i = 0; i < liveness->active_count;)
+    {
+        if (liveness->active_last_use[i] >= level)
+        {
+            ++i;
+            continue;
+        }
+
+        liveness->free_buffers[liveness->free_count++] = liveness->active_buffers[i];
+        const size_t last = --liveness->active_count;
+        liveness->active_buffers[i] = liveness->active_buffers[last];
+        liveness->active_last_use[i] = liveness->active_last_use[last];
+    }
+}
+
+// Maps the outputs onto g_buffer_pool like a register allocator: an output
+// written at level L and last read at level R holds a buffer over [L, R], the
+// buffer is free again when level R + 1 starts. Modules of a level may be
+// batched and run in any order, so nothing is reused within a level. Outputs nobody
+// reads still get a buffer for their own level, modules use them as scratch.
+//
+// Outputs read by a sink (read after the block) or through a feedback cable
+// (read before they're written) keep their buffer for the whole block.
+//
+// The free list is a stack, a writer gets the buffer released last, the one
+// most likely to still be in cache. Inputs are then pointed at the buffer of
+// their source.
+static void tr_assign_buffers(const tr_schedule_t* schedule, rack_t* rack)
+{
+    tr_buffer_liveness_t* liveness = &g_buffer_liveness;
+    const size_t module_count = rack->gui_module_count;
+
+    // The UI may be rewriting the type of a removed slot it's reusing, those
+    // have no fields here.
+    uint32_t field_count = 0;
+    for (size_t i = 0; i < module_count; ++i)
+    {
+        liveness->field_offset[i] = field_count;
+        if (!atomic_load_explicit(&rack->gui_modules[i].removed, memory_order_acquire))
+        {
+            field_count += tr_module_infos[rack->gui_modules[i].type].field_count;
+        }
+    }
+    assert(field_count <= TR_MAX_MODULE_FIELDS);
+
+    for (uint32_t i = 0; i < field_count; ++i)
+    {
+        liveness->last_use[i] = -1;
+    }
+
+    for (size_t p = 0; p < schedule->module_count; ++p)
+    {
+        const tr_gui_module_t* module = schedule->modules[p];
+        const bool sink = tr_module_is_sink(module->type);
+
+        for (uint16_t c = tr_rack_first_input_cable(rack, tr_get_gui_module_index(rack, module)); c != 0; c = rack->cables[c].next_input)
+        {
+            const tr_cable_t* cable = &rack->cables[c];
+            if (rack->gui_modules[cable->source_module].removed)
+            {
+                continue;
+            }
+
+            const bool persistent = sink || cable->feedback;
+            const int32_t level = persistent ? TR_BUFFER_PERSISTENT : schedule->module_levels[p];
+
+            int32_t* last_use = &liveness->last_use[liveness->field_offset[cable->source_module] + cable->source_field];
+            if (level > *last_use)
+            {
+                *last_use = level;
+            }
+        }
+    }
+
+    // buffer 0 is the silent one, never handed out
+    liveness->free_count = 0;
+    liveness->active_count = 0;
+    for (size_t i = TR_BUFFER_POOL_COUNT - 1; i > 0; --i)
+    {
+        liveness->free_buffers[liveness->free_count++] = (uint16_t)i;
+    }
+
+    size_t used_count = 1;
+    int32_t current_level = -1;
+
+    for (size_t p = 0; p < schedule->module_count; ++p)
+    {
+        tr_gui_module_t* module = schedule->modules[p];
+        const int32_t level = schedule->module_levels[p];
+
+        if (level != current_level)
+        {
+            tr_buffer_liveness_release(liveness, level);
+            current_level = level;
+        }
+
+        const tr_module_info_t* module_info = &tr_module_infos[module->type];
+        const uint32_t field_offset = liveness->field_offset[tr_get_gui_module_index(rack, module)];
+
+        for (size_t field_index = 0; field_index < module_info->field_count; ++field_index)
+        {
+            if (module_info->fields[field_index].type != TR_MODULE_FIELD_BUFFER)
+            {
+                continue;
+            }
+
+            // can't be empty, see TR_BUFFER_POOL_COUNT
+            assert(liveness->free_count > 0);
+            const uint16_t buffer = liveness->free_buffers[--liveness->free_count];
+            *(float**)get_field_address(module, field_index) = g_buffer_pool[buffer];
+            if (buffer + 1u > used_count)
+            {
+                used_count = buffer + 1u;
+            }
+
+            const int32_t last_use = liveness->last_use[field_offset + field_index];
+            if (last_use != TR_BUFFER_PERSISTENT)
+            {
+                liveness->active_buffers[liveness->active_count] = buffer;
+                liveness->active_last_use[liveness->active_count] = last_use > level ? last_use : level;
+                ++liveness->active_count;
+            }
+        }
+    }
+
+    // Pruned modules aren't updated, they and whatever reads them get silence.
+    for (size_t i = 0; i < module_count; ++i)
+    {
+        const tr_gui_module_t* module = &rack->gui_modules[i];
+        if (!module->pruned || module->removed)
+        {
+            continue;
+        }
+
+        const tr_module_info_t* module_info = &tr_module_infos[module->type];
+        for (size_t field_index = 0; field_index < module_info->field_count; ++field_index)
+        {
+            if (module_info->fields[field_index].type == TR_MODULE_FIELD_BUFFER)
+            {
+                *(float**)get_field_address(module, field_index) = g_buffer_pool[0];
+            }
+        }
+    }
+
+    // The previous schedule left unrelated audio in the buffers, feedback
+    // cables read silence for the first block instead.
+    memset(g_buffer_pool[1], 0, sizeof(g_buffer_pool[0]) * (used_count - 1));
+
+    for (size_t i = 0; i < module_count; ++i)
+    {
+        for (uint16_t c = tr_rack_first_input_cable(rack, i); c != 0; c = rack->cables[c].next_input)
+        {
+            // removed but not disconnected yet
+            const tr_cable_t* cable = &rack->cables[c];
+            const tr_gui_module_t* source = &rack->gui_modules[cable->source_module];
+            const float** input = get_field_address(&rack->gui_modules[i], cable->target_field);
+            *input = source->removed ? g_buffer_pool[0] : *(float**)get_field_address(source, cable->source_field);
+        }
+    }
+}
+
+#if TR_RELOCATE_MODULES
+// Scratch space for tr_relocate_modules
+typedef struct tr_module_relocation
+{
+    uint16_t order[TR_GUI_MODULE_COUNT];
+    bool ordered[TR_GUI_MODULE_COUNT];
+} tr_module_relocation_t;
+
+static tr_module_relocation_t g_module_relocation;
+
+// Follows the module data when the address points into it.
+static void* tr_relocate_address(const void* address, const uint8_t* old_data, uint8_t* new_data, size_t size)
+{
+    const uint8_t* p = address;
+    if (p < old_data || p >= old_data + size)
+    {
+        return (void*)address;
+    }
+    return new_data + (p - old_data);
+}
+
+// Copies the module data into the other arena of the pool, scheduled modules
+// first and in update order, then the pruned ones. The blocks the free lists
+// held and the data of the released modules stay behind, the new arena
+// starts without holes.
+//
+// Inputs and outputs point into g_buffer_pool and cables refer to module and
+// field indices, they're copied as is. Only the UI pointers to knobs and
+// plugs have to follow their module.
+static void tr_relocate_modules(const tr_schedule_t* schedule, rack_t* rack)
+{
+    tr_module_relocation_t* relocation = &g_module_relocation;
+    tr_module_pool_t* pool = &rack->module_pool;
+    const size_t module_count = rack->gui_module_count;
+
+    // Modules removed by the commands just applied are disconnected, nothing
+    // refers to them once the schedule is rebuilt.
+    for (size_t i = 0; i < rack->releasing_count; ++i)
+    {
+        rack->gui_modules[rack->releasing[i]].data = NULL;
+    }
+
+    size_t order_count = 0;
+    memset(relocation->ordered, 0, sizeof(relocation->ordered[0]) * module_count);
+    for (size_t p = 0; p < schedule->module_count; ++p)
+    {
+        const size_t index = tr_get_gui_module_index(rack, schedule->modules[p]);
+        relocation->order[order_count++] = (uint16_t)index;
+        relocation->ordered[index] = true;
+    }
+    for (size_t i = 0; i < module_count; ++i)
+    {
+        tr_gui_module_t* module = &rack->gui_modules[i];
+        if (module->released)
+        {
+            module->data = NULL;
+        }
+        if (!relocation->ordered[i] && module->data != NULL)
+        {
+            relocation->order[order_count++] = (uint16_t)i;
+        }
+    }
+
+    pool->arena = (pool->arena + 1) % TR_MODULE_POOL_ARENA_COUNT;
+    pool->data = g_module_pool_memory[pool->arena];
+    pool->offset = 0;
+    memset(pool->free_lists, 0, sizeof(pool->free_lists));
+
+    for (size_t o = 0; o < order_count; ++o)
+    {
+        tr_gui_module_t* module = &rack->gui_modules[relocation->order[o]];
+        const tr_module_info_t* module_info = &tr_module_infos[module->type];
+
+        uint8_t* old_data = module->data;
+        uint8_t* new_data = tr_module_pool_alloc(pool, module_info->struct_size);
+        memcpy(new_data, old_data, module_info->struct_size);
+        module->data = new_data;
+
+        g_input.active_value = tr_relocate_address(g_input.active_value, old_data, new_data, module_info->struct_size);
+        g_input.drag_input = tr_relocate_address(g_input.drag_input, old_data, new_data, module_info->struct_size);
+        g_input.drag_output = tr_relocate_address(g_input.drag_output, old_data, new_data, module_info->struct_size);
+    }
+}
+#endif
+
+// The scopes that get a view published, the ones left out are pruned or
+// didn't get a view.
+static void tr_find_scopes(tr_schedule_t* schedule)
+{
+    schedule->scope_count = 0;
+    for (size_t i = 0; i < schedule->module_count; ++i)
+    {
+        const tr_gui_module_t* module = schedule->modules[i];
+        if (module->type == TR_SCOPE && module->scope_view != 0)
+        {
+            schedule->scopes[schedule->scope_count++] = module;
+        }
+    }
+}
+
+static void tr_publish_scope_views(const tr_schedule_t* schedule)
+{
+    for (size_t i = 0; i < schedule->scope_count; ++i)
+    {
+        const tr_gui_module_t* module = schedule->scopes[i];
+        const tr_scope_t* scope = (const tr_scope_t*)module->data;
+        tr_scope_view_t* view = &g_scope_views[module->scope_view - 1];
+
+        view->connected[view->back] = scope->in_0 != NULL;
+        if (scope->in_0 != NULL)
+        {
+            memcpy(view->samples[view->back], scope->in_0, sizeof(view->samples[0]));
+        }
+
+        const unsigned middle = atomic_exchange_explicit(&view->middle, view->back | TR_SCOPE_VIEW_FRESH, memory_order_acq_rel);
+        view->back = middle & ~TR_SCOPE_VIEW_FRESH;
+    }
+}
+
+static void tr_compile_schedule(tr_schedule_t* schedule, rack_t* rack)
+{
+    schedule->module_count = tr_resolve_module_graph(schedule->modules, schedule->module_levels, rack);
+    schedule->entry_count = 0;
+    schedule->batch_count = 0;
+
+    tr_assign_buffers(schedule, rack);
+
+    // before the entries, they hold the data pointers
+#if TR_RELOCATE_MODULES
+    tr_relocate_modules(schedule, rack);
+#endif
+
+    int current_level = -1;
+    size_t level_first_batch = 0;
+    for (size_t i = 0; i < schedule->module_count; ++i)
+    {
+        tr_gui_module_t* module = schedule->modules[i];
+        const tr_module_vtable_t* vtable = &tr_module_vtable[module->type];
+
+        // input pointers only change with the cables, which rebuild the schedule
+        const tr_module_update_fn update = vtable->specialize != NULL ? vtable->specialize(module->data) : vtable->update;
+        if (update == NULL)
+        {
+            continue;
+        }
+
+        // batches don't span levels
+        if (schedule->module_levels[i] != current_level)
+        {
+            current_level = schedule->module_levels[i];
+            level_first_batch = schedule->batch_count;
+        }
+
+        if (vtable->batch != NULL)
+        {
+            tr_schedule_add_batched(schedule, level_first_batch, vtable->batch, module->data);
+            continue;
+        }
+
+        schedule->entries[schedule->entry_count++] = (tr_schedule_entry_t){update, module->data};
+    }
+
+    schedule->speaker = tr_find_speaker(rack);
+    tr_find_scopes(schedule);
+    schedule->valid = true;
+
+    // The modules removed since the last schedule aren't referenced anymore.
+    for (size_t i = 0; i < rack->releasing_count; ++i)
+    {
+        atomic_store_explicit(&rack->gui_modules[rack->releasing[i]].released, true, memory_order_release);
+    }
+    rack->releasing_count = 0;
+}
+
+// Unplugs the cables of the module, both ways.
+static void tr_rack_disconnect_module(rack_t* rack, size_t module_index)
+{
+    while (rack->first_input_cable[module_index] != 0)
+    {
+        const tr_cable_t* cable = &rack->cables[rack->first_input_cable[module_index]];
+        tr_rack_disconnect(rack, cable->target_module, cable->target_field);
+    }
+
+    while (rack->first_output_cable[module_index] != 0)
+    {
+        const tr_cable_t* cable = &rack->cables[rack->first_output_cable[module_index]];
+        tr_rack_disconnect(rack, cable->target_module, cable->target_field);
+    }
+}
+
+// Applies the UI edits queued since the last block. Cables and new modules
+// invalidate the schedule, it's rebuilt right after. The consumer side of
+// the queue must be claimed.
+static void tr_rack_apply_commands_internal(rack_t* rack, tr_command_queue_t* queue)
+{
+    tr_command_t command;
+    while (tr_command_queue_pop(queue, &command))
+    {
+        const tr_gui_module_t* module = &rack->gui_modules[command.module];
+
+        switch (command.type)
+        {
+            case TR_COMMAND_SET_FLOAT:
+                *(float*)get_field_address(module, command.field) = command.float_value;
+                break;
+
+            case TR_COMMAND_SET_INT:
+                *(int*)get_field_address(module, command.field) = command.int_value;
+                break;
+
+            case TR_COMMAND_CONNECT:
+                tr_rack_connect(rack, (tr_cable_t){
+                    .color = command.source.color,
+                    .source_module = command.source.module,
+                    .source_field = command.source.field,
+                    .target_module = command.module,
+                    .target_field = command.field,
+                });
+                tr_rack_invalidate_schedule(rack);
+                break;
+
+            case TR_COMMAND_DISCONNECT:
+                tr_rack_disconnect(rack, command.module, command.field);
+                tr_rack_invalidate_schedule(rack);
+                break;
+
+            case TR_COMMAND_ADD_MODULE:
+                tr_rack_invalidate_schedule(rack);
+                break;
+
+            case TR_COMMAND_REMOVE_MODULE:
+                tr_rack_disconnect_module(rack, command.module);
+                rack->releasing[rack->releasing_count++] = command.module;
+                tr_rack_invalidate_schedule(rack);
+                break;
+        }
+    }
+}
+
+void tr_rack_apply_commands(rack_t* rack, tr_command_queue_t* queue)
+{
+    if (!tr_command_queue_try_begin(queue))
+    {
+        return;
+    }
+
+    tr_rack_apply_commands_internal(rack, queue);
+    tr_command_queue_end(queue);
+}
+
 static void tr_produce_final_mix_internal(float* output, rack_t* rack)
 {
-    tr_gui_module_t* update_modules[TR_GUI_MODULE_COUNT];
-    const size_t update_count = tr_resolve_module_graph(update_modules, rack);
-    tr_update_modules(update_modules, update_count);
+    tr_schedule_t* schedule = &rack->schedule;
+
+    tr_rack_apply_commands(rack, &g_app.commands);
+
+    tb_start(&g_app.tb_resolve_module_graph);
+    if (!schedule->valid)
+    {
+        tr_compile_schedule(schedule, rack);
+    }
+    tb_stop(&g_app.tb_resolve_module_graph);
 
-    const tr_speaker_t* speaker = tr_find_speaker(rack);
+    tr_update_modules(schedule);
+    tr_publish_scope_views(schedule);
+
+    const tr_speaker_t* speaker = schedule->speaker;
     if (speaker == NULL)
     {
         memset(output, 0, sizeof(float) * TR_SAMPLE_COUNT);
@@ -1282,46 +2313,78 @@ void tr_produce_final_mix(float* output, rack_t* rack)
     tb_stop(&g_app.tb_produce_final_mix);
 }
 
-static float g_pcm_memory[128];
-float* pcm_alloc(void)
+// Rendered audio on its way to the AudioWorklet, single producer (engine),
+// single consumer (worklet). The indices count frames and wrap around, a
+// block is always written in one piece. With wasm threads the worklet reads
+// the ring in the shared memory, otherwise index.html mirrors it into a
+// SharedArrayBuffer with the same layout.
+typedef struct tr_audio_ring
+{
+    atomic_uint write; // only written by the engine
+    atomic_uint read; // only written by the worklet
+    uint32_t frame_count; // TR_AUDIO_RING_FRAMES, for the JS side
+    uint32_t padding;
+    float samples[TR_AUDIO_RING_FRAMES];
+} tr_audio_ring_t;
+
+_Static_assert(__builtin_offsetof(tr_audio_ring_t, samples) == 16, "audio-processor.js expects the samples at offset 16");
+
+static _Alignas(16) tr_audio_ring_t g_audio_ring = {.frame_count = TR_AUDIO_RING_FRAMES};
+
+tr_audio_ring_t* tr_audio_ring(void)
 {
-    return g_pcm_memory;
+    return &g_audio_ring;
 }
 
-void tr_audio_callback(void* bufferData, size_t frames)
+// Renders blocks straight into the ring until it's full.
+void tr_audio_render(void)
 {
-    float* samples = bufferData;
-    size_t write_cursor = 0;
+    tr_audio_ring_t* ring = &g_audio_ring;
+    const unsigned read = atomic_load_explicit(&ring->read, memory_order_acquire);
+    unsigned write = atomic_load_explicit(&ring->write, memory_order_relaxed);
 
-    //printf("frames: %d\n", frames);
+    // the worklet only moves the read index once the context runs
+    if (read != 0)
+    {
+        atomic_store_explicit(&g_app.is_audio_running, true, memory_order_relaxed);
+    }
 
-    while (write_cursor < frames)
+    while (TR_AUDIO_RING_FRAMES - (write - read) >= TR_SAMPLE_COUNT)
     {
-        if (g_app.final_mix_remaining == 0)
-        {
-            g_app.final_mix_remaining = TR_SAMPLE_COUNT;
-            tr_produce_final_mix(g_app.final_mix, &g_app.rack);
-        }
+        tr_produce_final_mix(&ring->samples[write & (TR_AUDIO_RING_FRAMES - 1)], &g_app.rack);
+        write += TR_SAMPLE_COUNT;
+        atomic_store_explicit(&ring->write, write, memory_order_release);
+    }
+}
 
-        const size_t final_mix_cursor = TR_SAMPLE_COUNT - g_app.final_mix_remaining;
-        const size_t frames_available = frames - write_cursor;
+#ifdef TR_WASM_THREADS
+// Body of the engine worker, never returns. Sleeps while the ring is full,
+// the worklet wakes it up when it moves the read index.
+void tr_engine_run(void)
+{
+    // The UI applies the edits until it sees the flag. It checks it with the
+    // queue claimed, so claiming the queue once here waits out a drain it may
+    // be in, the rack is the engine's from then on.
+    atomic_store(&g_app.is_engine_running, true);
+    while (!tr_command_queue_try_begin(&g_app.commands))
+    {
+    }
+    tr_command_queue_end(&g_app.commands);
+
+    tr_audio_ring_t* ring = &g_audio_ring;
+    for (;;)
+    {
+        tr_audio_render();
 
-        size_t final_mix_available = g_app.final_mix_remaining;
-        if (final_mix_available > frames_available)
+        const unsigned read = atomic_load_explicit(&ring->read, memory_order_acquire);
+        const unsigned write = atomic_load_explicit(&ring->write, memory_order_relaxed);
+        if (TR_AUDIO_RING_FRAMES - (write - read) < TR_SAMPLE_COUNT)
         {
-            final_mix_available = frames_available;
+            __builtin_wasm_memory_atomic_wait32((int*)&ring->read, (int)read, -1);
         }
-
-        //printf("write_cursor: %zu, final_mix_cursor: %zu, final_mix_available: %zu\n", write_cursor, final_mix_cursor, final_mix_available);
-        
-        memcpy(samples + write_cursor, g_app.final_mix + final_mix_cursor, final_mix_available * sizeof(float));
-
-        write_cursor += final_mix_available;
-        g_app.final_mix_remaining -= final_mix_available;
     }
-
-    g_app.has_audio_callback_been_called_once = true;
 }
+#endif
 
 rectangle_t tr_compute_patch_bounds(rack_t* rack)
 {
@@ -1337,6 +2400,11 @@ rectangle_t tr_compute_patch_bounds(rack_t* rack)
 
     for (size_t i = 0; i < rack->gui_module_count; ++i)
     {
+        if (rack->gui_modules[i].removed)
+        {
+            continue;
+        }
+
         const tr_module_info_t* module_info = &tr_module_infos[rack->gui_modules[i].type];
         float x = (float)rack->gui_modules[i].x;
         float y = (float)rack->gui_modules[i].y;
@@ -1433,8 +2501,26 @@ void tr_frame_update_draw(void)
 
     tb_start(&app->tb_update_input);
 
+    tr_rack_reclaim_modules(rack);
     tr_update_closest_input_state(&g_input, rack, get_screen_to_world(get_mouse_position(), g_input.camera));
 
+    if ((is_key_pressed(PL_KEY_DELETE) || is_key_pressed(PL_KEY_BACKSPACE)) &&
+        !app->picker_mode &&
+        g_input.drag_input == NULL &&
+        g_input.drag_output == NULL &&
+        g_input.active_value == NULL)
+    {
+        tr_gui_module_t* module = tr_rack_module_at(rack, get_screen_to_world(get_mouse_position(), g_input.camera));
+        if (module != NULL && tr_rack_remove_module(rack, &app->commands, module))
+        {
+            if (g_input.drag_module == module)
+            {
+                g_input.drag_module = NULL;
+            }
+            tr_update_closest_input_state(&g_input, rack, get_screen_to_world(get_mouse_position(), g_input.camera));
+        }
+    }
+
     if (is_mouse_button_pressed(PL_MOUSE_BUTTON_LEFT))
     {
         if (g_input.closest_distance[g_input.closest_input] < 0.0f)
@@ -1447,15 +2533,16 @@ void tr_frame_update_draw(void)
                 const float** input = get_field_address(module, field);
 
 #if 0 // don't think this is good UX
-                if (*input != NULL)
+                const tr_gui_cable_t* cable = &rack->gui_cables[tr_get_gui_module_index(rack, module)][field];
+                if (cable->connected)
                 {
-                    const int input_plug_idx = tr_hmget(rack->input_plugs_key, input);
-                    assert(input_plug_idx != -1);
-                    const tr_input_plug_t* input_plug = &rack->input_plugs[input_plug_idx];
-
                     g_input.drag_output = *input;
-                    g_input.drag_color = input_plug->color;
-                    *input = NULL;
+                    g_input.drag_color = cable->color;
+                    tr_rack_push_command(rack, &app->commands, &(tr_command_t){
+                        .type = TR_COMMAND_DISCONNECT,
+                        .module = (uint16_t)tr_get_gui_module_index(rack, module),
+                        .field = (uint16_t)field,
+                    });
                 }
                 else
 #endif
@@ -1547,7 +2634,10 @@ void tr_frame_update_draw(void)
     g_input.do_not_process_input = app->picker_mode;
     for (size_t i = 0; i < rack->gui_module_count; ++i)
     {
-        tr_gui_module_draw(rack, &rack->gui_modules[i]);
+        if (!rack->gui_modules[i].removed)
+        {
+            tr_gui_module_draw(rack, &rack->gui_modules[i]);
+        }
     }
     g_input.do_not_process_input = false;
 
@@ -1598,13 +2688,13 @@ void tr_frame_update_draw(void)
             {
                 const tr_gui_module_t* drop_module = g_input.closest_module[TR_INPUT_TYPE_OUTPUT_PLUG];
                 const size_t drop_field_index = g_input.closest_field[TR_INPUT_TYPE_OUTPUT_PLUG];
-                const float* output = get_field_address(drop_module, drop_field_index);
-
-                const int input_plug_idx = tr_hmput(rack->input_plugs_key, g_input.drag_input);
-                rack->input_plugs[input_plug_idx] = (tr_input_plug_t){g_input.drag_color};
-                const int output_plug_idx = tr_hmput(rack->output_plugs_key, output);
-                rack->output_plugs[output_plug_idx] = (tr_output_plug_t){drop_module, &tr_module_infos[drop_module->type].fields[drop_field_index]};
-                *g_input.drag_input = output;
+                const tr_module_field_info_t* fields = tr_module_infos[g_input.drag_io_module->type].fields;
+                tr_rack_push_command(rack, &app->commands, &(tr_command_t){
+                    .type = TR_COMMAND_CONNECT,
+                    .module = (uint16_t)tr_get_gui_module_index(rack, g_input.drag_io_module),
+                    .field = (uint16_t)(g_input.drag_field - fields),
+                    .source = {(uint16_t)tr_get_gui_module_index(rack, drop_module), (uint16_t)drop_field_index, g_input.drag_color},
+                });
             }
 #if 0
             else
@@ -1620,13 +2710,13 @@ void tr_frame_update_draw(void)
             {
                 const tr_gui_module_t* drop_module = g_input.closest_module[TR_INPUT_TYPE_INPUT_PLUG];
                 const size_t drop_field_index = g_input.closest_field[TR_INPUT_TYPE_INPUT_PLUG];
-                const float** drop_input = get_field_address(drop_module, drop_field_index);
-
-                const int input_plug_idx = tr_hmput(rack->input_plugs_key, drop_input);
-                rack->input_plugs[input_plug_idx] = (tr_input_plug_t){g_input.drag_color};
-                const int output_plug_idx = tr_hmput(rack->output_plugs_key, g_input.drag_output);
-                rack->output_plugs[output_plug_idx] = (tr_output_plug_t){g_input.drag_io_module, g_input.drag_field};
-                *drop_input = g_input.drag_output;
+                const tr_module_field_info_t* fields = tr_module_infos[g_input.drag_io_module->type].fields;
+                tr_rack_push_command(rack, &app->commands, &(tr_command_t){
+                    .type = TR_COMMAND_CONNECT,
+                    .module = (uint16_t)tr_get_gui_module_index(rack, drop_module),
+                    .field = (uint16_t)drop_field_index,
+                    .source = {(uint16_t)tr_get_gui_module_index(rack, g_input.drag_io_module), (uint16_t)(g_input.drag_field - fields), g_input.drag_color},
+                });
             }
         }
 
@@ -1667,12 +2757,20 @@ void tr_frame_update_draw(void)
                 g_input.drag_module == NULL)
             {
                 const float2 mouse = get_mouse_position();
+                // Without the ADD_MODULE the engine wouldn't rebuild the
+                // schedule and the module would stay silent, so nothing is
+                // created while the queue is full.
                 if (mouse.x > x && 
                     mouse.y > y &&
                     mouse.x < x + module_info->width && 
-                    mouse.y < y + module_info->height)
+                    mouse.y < y + module_info->height &&
+                    tr_command_queue_can_push(&app->commands))
                 {
                     tr_gui_module_t* module = tr_rack_create_module(rack, module_type);
+                    tr_command_queue_push(&app->commands, &(tr_command_t){
+                        .type = TR_COMMAND_ADD_MODULE,
+                        .module = (uint16_t)tr_get_gui_module_index(rack, module),
+                    });
                     module->x = (int)mouse.x;
                     module->y = (int)mouse.y;
                     g_input.drag_module = module;
@@ -1689,7 +2787,7 @@ void tr_frame_update_draw(void)
     }
 
 #ifdef PLATFORM_WEB
-    if (!g_app.has_audio_callback_been_called_once)
+    if (!atomic_load_explicit(&g_app.is_audio_running, memory_order_relaxed))
     {
         const char* message = "Click anywhere to enable audio playback.";
         const float2 message_size = measure_text(FONT_BERKELY_MONO, message, 22, 0);
@@ -1802,6 +2900,18 @@ void tr_frame_update_draw(void)
     }
 #endif
 
+    // Nobody else applies the edits until audio is running or the engine
+    // worker has taken the rack over, see tr_engine_run. The flag has to be
+    // read with the queue claimed.
+    if (tr_command_queue_try_begin(&app->commands))
+    {
+        if (!atomic_load(&app->is_engine_running) && !atomic_load_explicit(&app->is_audio_running, memory_order_relaxed))
+        {
+            tr_rack_apply_commands_internal(rack, &app->commands);
+        }
+        tr_command_queue_end(&app->commands);
+    }
+
     tb_stop(&g_app.tb_frame_update_draw);
 }
 
@@ -1969,6 +3079,8 @@ int _start()
     g_input.camera.target.y = bounds.y + bounds.height * 0.5f;
 #endif
 
+    tr_adsr_lut_init();
+    tr_wavetable_init();
     platform_init(TR_SAMPLE_RATE, TR_SAMPLE_COUNT, NULL);
 
 #ifdef TR_RECORDING_FEATURE
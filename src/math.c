@@ -1,79 +1,84 @@
 #include "math.h"
 
-float tr_sinf(float x)
+// The approximations are written without branches and shared between the
+// scalar functions and the _buf versions, so both give the same results and
+// the compiler can vectorize the _buf loops. Each function comes in three
+// tiers, TR_MATH_TIER picks the one behind the unsuffixed names. Run
+// mathbench to see the error and cost of each tier.
+
+typedef union { float f; int32_t i; uint32_t u; } tr_float_bits_t;
+
+// 2^k for k in [-126, 127], built in the exponent bits
+static inline float tr_pow2i(int32_t k)
+{
+    tr_float_bits_t v = { .i = (k + 127) << 23 };
+    return v.f;
+}
+
+//
+// fast: parabolic sine and short series, ~1e-3 relative error
+//
+
+static inline float tr_sinf_fast_kernel(float x)
 {
     // wrap to [-π, π]
-    if (x < -TR_PI) x += TR_TWOPI;
-    if (x >  TR_PI) x -= TR_TWOPI;
+    x += x < -(float)TR_PI ? (float)TR_TWOPI : 0.0f;
+    x -= x > (float)TR_PI ? (float)TR_TWOPI : 0.0f;
 
     // parabolic approximation
-    float y = 1.27323954f * x - 0.405284735f * x * (x < 0 ? -x : x);
-    //y = 0.225f * (y * (y < 0 ? -y : y) - y) + y;
+    float y = 1.27323954f * x - 0.405284735f * x * tr_fabsf(x);
     return y;
 }
 
-float tr_cosf(float x)
+static inline float tr_cosf_fast_kernel(float x)
 {
-    return tr_sinf(x + 1.57079632f); // π/2
+    return tr_sinf_fast_kernel(x + 1.57079632f); // π/2
 }
 
-float tr_tanf(float x)
+static inline float tr_tanf_fast_kernel(float x)
 {
-    return tr_sinf(x) / tr_cosf(x);
+    return tr_sinf_fast_kernel(x) / tr_cosf_fast_kernel(x);
 }
 
-float tr_fmodf(float x, float y)
+static inline float tr_expf_fast_kernel(float x)
 {
-    int q = (int)(x / y);
-    float r = x - (float)q * y;
-    if (r < 0) r += y; // force positive result
-    return r;
-}
-
-float tr_expf(float x) {
     // constants
     const float LN2 = 0.69314718056f;       // ln(2)
     const float INV_LN2 = 1.44269504089f;   // 1/ln(2)
 
-    // reduce: x = k*ln2 + r,  with r in [-ln2/2, ln2/2]
+    // reduce: x = k*ln2 + r,  with r in (-ln2, ln2)
     int k = (int)(x * INV_LN2);
     float r = x - k * LN2;
 
-    // approximate e^r with a polynomial (order-3 minimax)
+    // approximate e^r with a polynomial
     // e^r ≈ 1 + r + r^2/2 + r^3/6
     float r2 = r * r;
     float r3 = r2 * r;
     float exp_r = 1.0f + r + 0.5f*r2 + 0.16666667f*r3;
 
     // reconstruct: exp(x) = 2^k * e^r
-    int32_t bits = (k + 127) << 23;   // build 2^k in IEEE754
-    float two_to_k = *(float*)&bits;
-
-    return two_to_k * exp_r;
+    return tr_pow2i(k) * exp_r;
 }
 
-float tr_exp2f(float x)
+static inline float tr_exp2f_fast_kernel(float x)
 {
     // Split x into integer and fractional parts
     int i = (int)x;
     float f = x - (float)i;
 
     // Polynomial approximation for 2^f, f in [0,1)
-    // minimax cubic fit: 2^f ≈ 1 + f*(0.69314718 + f*(0.24022651 + f*0.05550411))
+    // cubic fit: 2^f ≈ 1 + f*(0.69314718 + f*(0.24022651 + f*0.05550411))
     float p = 1.0f + f * (0.69314718f + f * (0.24022651f + f * 0.05550411f));
 
-    // Build 2^i via exponent bits
-    int32_t e = (i + 127) << 23; // IEEE754 bias 127
-    float two_to_i = *(float*)&e; // reinterpret as float
-
-    return two_to_i * p;
+    return tr_pow2i(i) * p;
 }
 
-float tr_logf(float x) {
-    union { float f; uint32_t i; } v = { x };
+static inline float tr_logf_fast_kernel(float x)
+{
+    tr_float_bits_t v = { x };
 
-    int exp = ((v.i >> 23) & 0xFF) - 127;   // unbiased exponent
-    v.i = (v.i & 0x7FFFFF) | 0x3F800000;    // force mantissa into [1,2)
+    int exp = ((v.u >> 23) & 0xFF) - 127;   // unbiased exponent
+    v.u = (v.u & 0x7FFFFF) | 0x3F800000;    // force mantissa into [1,2)
 
     float m = v.f;
     float y = m - 1.0f;
@@ -86,6 +91,299 @@ float tr_logf(float x) {
     return (float)exp * 0.69314718056f + log_m;
 }
 
+//
+// medium: refined parabola and longer series with a centered reduction,
+// ~1e-5 relative error (sine ~1e-3 absolute)
+//
+
+static inline float tr_sinf_medium_kernel(float x)
+{
+    float y = tr_sinf_fast_kernel(x);
+
+    // second parabola pass over the first one
+    return 0.225f * (y * tr_fabsf(y) - y) + y;
+}
+
+static inline float tr_cosf_medium_kernel(float x)
+{
+    return tr_sinf_medium_kernel(x + 1.57079632f); // π/2
+}
+
+static inline float tr_tanf_medium_kernel(float x)
+{
+    return tr_sinf_medium_kernel(x) / tr_cosf_medium_kernel(x);
+}
+
+// 2^r for r in [-0.5, 0.5], degree 4 Taylor series of e^(r*ln2)
+static inline float tr_exp2f_medium_poly(float r)
+{
+    return 1.0f + r * (0.69314718f + r * (0.24022651f + r * (0.05550411f + r * 0.00961813f)));
+}
+
+static inline float tr_expf_medium_kernel(float x)
+{
+    // x = k*ln2 + r, with r in [-ln2/2, ln2/2]
+    const float k = tr_floorf(x * (float)TR_LOG2E + 0.5f);
+    const float r = x * (float)TR_LOG2E - k;
+
+    return tr_pow2i((int32_t)k) * tr_exp2f_medium_poly(r);
+}
+
+static inline float tr_exp2f_medium_kernel(float x)
+{
+    const float k = tr_floorf(x + 0.5f);
+
+    return tr_pow2i((int32_t)k) * tr_exp2f_medium_poly(x - k);
+}
+
+// Splits x into m * 2^e with m in [sqrt(1/2), sqrt(2)), returns m - 1
+static inline float tr_logf_reduce(float x, float* e)
+{
+    tr_float_bits_t v = { x };
+
+    int32_t exp = (int32_t)((v.u >> 23) & 0xFF) - 126;
+    v.u = (v.u & 0x7FFFFF) | 0x3F000000;    // mantissa in [0.5, 1)
+
+    const int32_t below = v.f < (float)TR_SQRT1_2;
+    *e = (float)(exp - below);
+
+    return below ? v.f + v.f - 1.0f : v.f - 1.0f;
+}
+
+static inline float tr_logf_medium_kernel(float x)
+{
+    float e;
+    const float y = tr_logf_reduce(x, &e);
+
+    // log(1+y) = 2*atanh(s), s = y/(2+y) in [-0.172, 0.172]
+    const float s = y / (2.0f + y);
+    const float s2 = s * s;
+    const float log_m = 2.0f * s * (1.0f + s2 * (1.0f/3.0f + s2 * (1.0f/5.0f)));
+
+    return e * (float)TR_LN2 + log_m;
+}
+
+//
+// precise: full range reduction and minimax polynomials, within a few ulp
+// (cephes single precision coefficients)
+//
+
+// x = q*π/2 + r with r in [-π/4, π/4], π/2 is split in three parts so the
+// products with q are exact
+static inline float tr_trig_reduce(float x, int32_t* q)
+{
+    const float k = tr_floorf(x * (float)TR_2_PI + 0.5f);
+    *q = (int32_t)k;
+
+    x = x - k * 1.5703125f;
+    x = x - k * 4.837512969970703125e-4f;
+    x = x - k * 7.54978995489188216e-8f;
+    return x;
+}
+
+static inline float tr_sin_poly(float r)
+{
+    const float z = r * r;
+    return ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * r + r;
+}
+
+static inline float tr_cos_poly(float r)
+{
+    const float z = r * r;
+    return ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f) * z * z - 0.5f * z + 1.0f;
+}
+
+static inline float tr_sinf_precise_kernel(float x)
+{
+    int32_t q;
+    const float r = tr_trig_reduce(x, &q);
+
+    const float s = (q & 1) ? tr_cos_poly(r) : tr_sin_poly(r);
+    return (q & 2) ? -s : s;
+}
+
+static inline float tr_cosf_precise_kernel(float x)
+{
+    int32_t q;
+    const float r = tr_trig_reduce(x, &q);
+
+    const float c = (q & 1) ? tr_sin_poly(r) : tr_cos_poly(r);
+    return ((q + 1) & 2) ? -c : c;
+}
+
+static inline float tr_tanf_precise_kernel(float x)
+{
+    int32_t q;
+    const float r = tr_trig_reduce(x, &q);
+
+    const float s = tr_sin_poly(r);
+    const float c = tr_cos_poly(r);
+    return (q & 1) ? -c / s : s / c;
+}
+
+// e^r for r in [-ln2/2, ln2/2]
+static inline float tr_expf_precise_poly(float r)
+{
+    const float z = r * r;
+    const float p = ((((1.9875691500e-4f * r + 1.3981999507e-3f) * r + 8.3334519073e-3f) * r
+        + 4.1665795894e-2f) * r + 1.6666665459e-1f) * r + 5.0000001201e-1f;
+    return p * z + r + 1.0f;
+}
+
+static inline float tr_expf_precise_kernel(float x)
+{
+    // keep 2^k a normal float
+    x = x < -87.0f ? -87.0f : x;
+    x = x > 88.0f ? 88.0f : x;
+
+    // x = k*ln2 + r, ln2 split in two parts
+    const float k = tr_floorf(x * (float)TR_LOG2E + 0.5f);
+    float r = x - k * 0.693359375f;
+    r = r + k * 2.12194440e-4f;
+
+    return tr_pow2i((int32_t)k) * tr_expf_precise_poly(r);
+}
+
+static inline float tr_exp2f_precise_kernel(float x)
+{
+    x = x < -126.0f ? -126.0f : x;
+    x = x > 127.0f ? 127.0f : x;
+
+    const float k = tr_floorf(x + 0.5f);
+
+    return tr_pow2i((int32_t)k) * tr_expf_precise_poly((x - k) * (float)TR_LN2);
+}
+
+static inline float tr_logf_precise_kernel(float x)
+{
+    float e;
+    const float y = tr_logf_reduce(x, &e);
+
+    const float z = y * y;
+    float p = ((((((((7.0376836292e-2f * y - 1.1514610310e-1f) * y + 1.1676998740e-1f) * y
+        - 1.2420140846e-1f) * y + 1.4249322787e-1f) * y - 1.6668057665e-1f) * y
+        + 2.0000714765e-1f) * y - 2.4999993993e-1f) * y + 3.3333331174e-1f) * y * z;
+
+    // ln2 split in two parts
+    p += e * -2.12194440e-4f;
+    p += -0.5f * z;
+    return y + p + e * 0.693359375f;
+}
+
+#if TR_MATH_TIER == TR_MATH_PRECISE
+#define TR_MATH_KERNEL(_Name) _Name##_precise_kernel
+#elif TR_MATH_TIER == TR_MATH_MEDIUM
+#define TR_MATH_KERNEL(_Name) _Name##_medium_kernel
+#else
+#define TR_MATH_KERNEL(_Name) _Name##_fast_kernel
+#endif
+
+float tr_sinf(float x)
+{
+    return TR_MATH_KERNEL(tr_sinf)(x);
+}
+
+float tr_cosf(float x)
+{
+    return TR_MATH_KERNEL(tr_cosf)(x);
+}
+
+float tr_tanf(float x)
+{
+    return TR_MATH_KERNEL(tr_tanf)(x);
+}
+
+float tr_fmodf(float x, float y)
+{
+    int q = (int)(x / y);
+    float r = x - (float)q * y;
+    if (r < 0) r += y; // force positive result
+    return r;
+}
+
+float tr_expf(float x)
+{
+    return TR_MATH_KERNEL(tr_expf)(x);
+}
+
+float tr_exp2f(float x)
+{
+    return TR_MATH_KERNEL(tr_exp2f)(x);
+}
+
+float tr_logf(float x)
+{
+    return TR_MATH_KERNEL(tr_logf)(x);
+}
+
+void tr_sinf_buf(float* out, const float* in, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        out[i] = TR_MATH_KERNEL(tr_sinf)(in[i]);
+    }
+}
+
+void tr_tanf_buf(float* out, const float* in, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        out[i] = TR_MATH_KERNEL(tr_tanf)(in[i]);
+    }
+}
+
+void tr_expf_buf(float* out, const float* in, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        out[i] = TR_MATH_KERNEL(tr_expf)(in[i]);
+    }
+}
+
+void tr_exp2f_buf(float* out, const float* in, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        out[i] = TR_MATH_KERNEL(tr_exp2f)(in[i]);
+    }
+}
+
+void tr_logf_buf(float* out, const float* in, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        out[i] = TR_MATH_KERNEL(tr_logf)(in[i]);
+    }
+}
+
+//
+// Named tiers
+//
+
+float tr_sinf_fast(float x) { return tr_sinf_fast_kernel(x); }
+float tr_sinf_medium(float x) { return tr_sinf_medium_kernel(x); }
+float tr_sinf_precise(float x) { return tr_sinf_precise_kernel(x); }
+
+float tr_cosf_fast(float x) { return tr_cosf_fast_kernel(x); }
+float tr_cosf_medium(float x) { return tr_cosf_medium_kernel(x); }
+float tr_cosf_precise(float x) { return tr_cosf_precise_kernel(x); }
+
+float tr_tanf_fast(float x) { return tr_tanf_fast_kernel(x); }
+float tr_tanf_medium(float x) { return tr_tanf_medium_kernel(x); }
+float tr_tanf_precise(float x) { return tr_tanf_precise_kernel(x); }
+
+float tr_expf_fast(float x) { return tr_expf_fast_kernel(x); }
+float tr_expf_medium(float x) { return tr_expf_medium_kernel(x); }
+float tr_expf_precise(float x) { return tr_expf_precise_kernel(x); }
+
+float tr_exp2f_fast(float x) { return tr_exp2f_fast_kernel(x); }
+float tr_exp2f_medium(float x) { return tr_exp2f_medium_kernel(x); }
+float tr_exp2f_precise(float x) { return tr_exp2f_precise_kernel(x); }
+
+float tr_logf_fast(float x) { return tr_logf_fast_kernel(x); }
+float tr_logf_medium(float x) { return tr_logf_medium_kernel(x); }
+float tr_logf_precise(float x) { return tr_logf_precise_kernel(x); }
+
 // simple powf(x, y)
 float tr_powf(float x, float y)
 {
@@ -2,6 +2,8 @@
 
 #include "types.h"
 
+#include <stddef.h>
+
 #define TR_E        2.71828182845904523536   // e
 #define TR_LOG2E    1.44269504088896340736   // log2(e)
 #define TR_LOG10E   0.434294481903251827651  // log10(e)
@@ -31,6 +33,35 @@ float tr_logf(float x);
 float tr_powf(float x, float y);
 float tr_roundf(float x);
 
+// Whole buffer versions, same results as the scalar functions. out may be in.
+void tr_sinf_buf(float* out, const float* in, size_t n);
+void tr_tanf_buf(float* out, const float* in, size_t n);
+void tr_expf_buf(float* out, const float* in, size_t n);
+void tr_exp2f_buf(float* out, const float* in, size_t n);
+void tr_logf_buf(float* out, const float* in, size_t n);
+
+// Explicit accuracy tiers, for a module that needs a different tier than the
+// build default (TR_MATH_TIER, config.h). Inputs of log must be positive and
+// normal. mathbench reports the error and cost of each one.
+float tr_sinf_fast(float x);
+float tr_sinf_medium(float x);
+float tr_sinf_precise(float x);
+float tr_cosf_fast(float x);
+float tr_cosf_medium(float x);
+float tr_cosf_precise(float x);
+float tr_tanf_fast(float x);
+float tr_tanf_medium(float x);
+float tr_tanf_precise(float x);
+float tr_expf_fast(float x);
+float tr_expf_medium(float x);
+float tr_expf_precise(float x);
+float tr_exp2f_fast(float x);
+float tr_exp2f_medium(float x);
+float tr_exp2f_precise(float x);
+float tr_logf_fast(float x);
+float tr_logf_medium(float x);
+float tr_logf_precise(float x);
+
 static inline int signbit(float x)
 {
     const uint32_t bits = *(uint32_t*)&x;
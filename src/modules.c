@@ -1,30 +1,192 @@
 #include "modules.h"
 #include "math.h"
 #include "stdlib.h"
+#include "simd.h"
+
+#include <stdbool.h>
+
+// Cables coming from a sequencer or a knob-like source hold the same value for
+// the whole block, kernels use this to do their per-sample math once.
+static bool tr_input_is_constant(tr_input in)
+{
+    const float v = in[0];
+    for (size_t i = 1; i < TR_SAMPLE_COUNT; ++i)
+    {
+        if (in[i] != v)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Knobs only change between two blocks. Rather than stepping, which is
+// audible as zipper noise, a moved knob is ramped linearly over the block:
+// sample i gets from + step * (i + 1) and the last one lands on the target.
+// Returns false when the knob hasn't moved so kernels keep their constant
+// path, the common case costs one compare.
+static inline bool tr_smooth(float* state, float target, float* from, float* step)
+{
+    if (*state == target)
+    {
+        return false;
+    }
+
+    *from = *state;
+    *step = (target - *state) * (1.0f / TR_SAMPLE_COUNT);
+    *state = target;
+    return true;
+}
+
+static inline float tr_smooth_at(float from, float step, size_t i)
+{
+    return from + step * (float)(i + 1);
+}
+
+// tr_smooth for kernels that ramp either way: a knob that hasn't moved gets
+// step 0, so tr_smooth_at gives the knob itself.
+static inline bool tr_smooth_ramp(float* state, float target, float* from, float* step)
+{
+    if (tr_smooth(state, target, from, step))
+    {
+        return true;
+    }
+
+    *from = target;
+    *step = 0.0f;
+    return false;
+}
+
+// Pitch knobs don't play 0Hz, a 0 state is an oscillator that hasn't run
+// yet. It starts on the knob instead of gliding up from 0Hz.
+static inline bool tr_smooth_pitch(float* state, float target, float* from, float* step)
+{
+    if (*state == 0.0f)
+    {
+        *state = target;
+    }
+    return tr_smooth_ramp(state, target, from, step);
+}
+
+static inline void tr_buf_fill(float* out, float v)
+{
+    tr_buf_fill_run(out, 0, TR_SAMPLE_COUNT, v);
+}
 
 //
 // tr_vco_t
 //
 
-void tr_vco_update(tr_vco_t* vco)
+static inline float tr_vco_advance(tr_vco_t* vco, float f)
+{
+    vco->phase += (f / TR_SAMPLE_RATE) * TR_TWOPI;
+    vco->phase = tr_fmodf(vco->phase, TR_TWOPI);
+    return vco->phase;
+}
+
+// PolyBLEP residual for a unit step at phase 0, t and dt are in cycles.
+// Subtracting it from a waveform with a downward jump of 2 at t = 0 rounds
+// the two samples around the jump off, which removes most of the aliasing
+// for the cost of a few multiplies per sample and no table.
+static inline float tr_polyblep(float t, float dt)
 {
+    const float a = t / dt;          // t in [0, dt), right after the jump
+    const float b = (t - 1.0f) / dt; // t in (1 - dt, 1), right before it
+
+    const float after = a + a - a * a - 1.0f;
+    const float before = b * b + b + b + 1.0f;
+
+    return t < dt ? after : (t > 1.0f - dt ? before : 0.0f);
+}
+
+// The phase accumulation is the only serial part. The phases are written to
+// out_saw first, the waveforms are then derived over the whole block. dt is
+// the phase increment of each sample, in cycles.
+static void tr_vco_shape(tr_vco_t* vco, const float* dt)
+{
+    tr_sinf_buf(vco->out_sin, vco->out_saw, TR_SAMPLE_COUNT);
+
     for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
     {
-        float f = vco->in_v0;
-        if (vco->in_voct != NULL)
+        // above half the sample rate the corrections would overlap
+        const float d = dt[i] < 1e-6f ? 1e-6f : (dt[i] > 0.5f ? 0.5f : dt[i]);
+
+        const float t = vco->out_saw[i] * (float)(0.5 * TR_1_PI);
+        const float t_half = t < 0.5f ? t + 0.5f : t - 0.5f;
+
+        // saw falls from 1 to -1 at t = 0, the square is -1 on [0, 0.5) and 1
+        // on [0.5, 1) so it also falls at t = 0 and rises at t = 0.5
+        vco->out_saw[i] = t + t - 1.0f - tr_polyblep(t, d);
+        vco->out_sqr[i] = (t < 0.5f ? -1.0f : 1.0f) - tr_polyblep(t, d) + tr_polyblep(t_half, d);
+    }
+}
+
+// in_voct unplugged or constant for the block, the pitch is in_v0 * mul
+static void tr_vco_update_fixed(tr_vco_t* vco, float mul)
+{
+    tr_buf dt;
+
+    float from, step;
+    if (tr_smooth_pitch(&vco->v0_smooth, vco->in_v0, &from, &step))
+    {
+        for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
         {
-            f = vco->in_v0 * tr_exp2f(vco->in_voct[i]);
+            const float f = tr_smooth_at(from, step, i) * mul;
+            vco->out_saw[i] = tr_vco_advance(vco, f);
+            dt[i] = f / TR_SAMPLE_RATE;
         }
 
-        vco->phase += (f / TR_SAMPLE_RATE) * TR_TWOPI;
-        vco->phase = tr_fmodf(vco->phase, TR_TWOPI);
+        tr_vco_shape(vco, dt);
+        return;
+    }
+
+    const float f = vco->in_v0 * mul;
+    tr_buf_fill(dt, f / TR_SAMPLE_RATE);
+
+    for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
+    {
+        vco->out_saw[i] = tr_vco_advance(vco, f);
+    }
+
+    tr_vco_shape(vco, dt);
+}
+
+static void tr_vco_update_free(tr_vco_t* vco)
+{
+    tr_vco_update_fixed(vco, 1.0f);
+}
+
+void tr_vco_update(tr_vco_t* vco)
+{
+    if (tr_input_is_constant(vco->in_voct))
+    {
+        tr_vco_update_fixed(vco, tr_exp2f(vco->in_voct[0]));
+        return;
+    }
+
+    float from, step;
+    tr_smooth_pitch(&vco->v0_smooth, vco->in_v0, &from, &step);
+
+    tr_buf dt;
+    tr_exp2f_buf(dt, vco->in_voct, TR_SAMPLE_COUNT);
+
+    for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
+    {
+        const float f = tr_smooth_at(from, step, i) * dt[i];
+        vco->out_saw[i] = tr_vco_advance(vco, f);
+        dt[i] = f / TR_SAMPLE_RATE;
+    }
+
+    tr_vco_shape(vco, dt);
+}
 
-        const float s = tr_sinf(vco->phase);
-        
-        vco->out_sin[i] = s;
-        vco->out_sqr[i] = signbit(s) ? 1.0f : -1.0f;
-        vco->out_saw[i] = vco->phase / TR_PI - 1.0f;
+tr_module_update_fn tr_vco_specialize(const tr_vco_t* vco)
+{
+    if (vco->in_voct == NULL)
+    {
+        return (tr_module_update_fn)tr_vco_update_free;
     }
+    return (tr_module_update_fn)tr_vco_update;
 }
 
 //
@@ -49,159 +211,289 @@ void tr_clock_update(tr_clock_t* clock)
 // tr_clockdiv_t
 //
 
+// No clock plugged: the counter holds, every output is a constant.
+static void tr_clockdiv_update_idle(tr_clockdiv_t* clockdiv)
+{
+    const int state = clockdiv->state;
+    float* outs[] = {
+        clockdiv->out_0, clockdiv->out_1, clockdiv->out_2, clockdiv->out_3,
+        clockdiv->out_4, clockdiv->out_5, clockdiv->out_6, clockdiv->out_7,
+    };
+
+    for (size_t bit = 0; bit < 8; ++bit)
+    {
+        tr_buf_fill(outs[bit], (state >> bit) & 1 ? 1.0f : -1.0f);
+    }
+
+    clockdiv->gate = 0;
+}
+
+// The counter only moves on a rising edge, so between two edges every
+// output is a constant: find the edges and fill the runs.
 void tr_clockdiv_update(tr_clockdiv_t* clockdiv)
 {
     int gate = clockdiv->gate;
     int state = clockdiv->state;
+    float* outs[] = {
+        clockdiv->out_0, clockdiv->out_1, clockdiv->out_2, clockdiv->out_3,
+        clockdiv->out_4, clockdiv->out_5, clockdiv->out_6, clockdiv->out_7,
+    };
 
-    for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
+    size_t i = 0;
+    while (i < TR_SAMPLE_COUNT)
     {
-        const int g = clockdiv->in_gate != NULL ? clockdiv->in_gate[i] > 0.0f : 0;
-        const int edge = g && g != gate;
+        const int g = clockdiv->in_gate[i] > 0.0f;
+        if (g && !gate)
+        {
+            state = (state + 1) & 0xff;
+        }
         gate = g;
-        
-        state = (state + edge) & 0xff;
-        
-        clockdiv->out_0[i] = (state & 0b00000001) ? 1.0f : -1.0f;
-        clockdiv->out_1[i] = (state & 0b00000010) ? 1.0f : -1.0f;
-        clockdiv->out_2[i] = (state & 0b00000100) ? 1.0f : -1.0f;
-        clockdiv->out_3[i] = (state & 0b00001000) ? 1.0f : -1.0f;
-        clockdiv->out_4[i] = (state & 0b00010000) ? 1.0f : -1.0f;
-        clockdiv->out_5[i] = (state & 0b00100000) ? 1.0f : -1.0f;
-        clockdiv->out_6[i] = (state & 0b01000000) ? 1.0f : -1.0f;
-        clockdiv->out_7[i] = (state & 0b10000000) ? 1.0f : -1.0f;
+
+        const size_t end = tr_buf_find_gate_edge(clockdiv->in_gate, i + 1, g);
+        for (size_t bit = 0; bit < 8; ++bit)
+        {
+            tr_buf_fill_run(outs[bit], i, end, (state >> bit) & 1 ? 1.0f : -1.0f);
+        }
+        i = end;
     }
 
     clockdiv->gate = gate;
     clockdiv->state = state;
 }
 
+tr_module_update_fn tr_clockdiv_specialize(const tr_clockdiv_t* clockdiv)
+{
+    if (clockdiv->in_gate == NULL)
+    {
+        return (tr_module_update_fn)tr_clockdiv_update_idle;
+    }
+    return (tr_module_update_fn)tr_clockdiv_update;
+}
+
 //
 // tr_seq8_t
 //
 
-void tr_seq8_update(tr_seq8_t* seq)
+// No step clock plugged: the current step is held for the whole block.
+static void tr_seq8_update_idle(tr_seq8_t* seq)
 {
-    //assert(seq->in_step != NULL);
+    seq->trig = 0;
+    tr_buf_fill(seq->out_cv, (&seq->in_cv_0)[seq->step]);
+}
 
-    for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
+// Same as the clock divider, the step only moves on a rising edge.
+void tr_seq8_update(tr_seq8_t* seq)
+{
+    size_t i = 0;
+    while (i < TR_SAMPLE_COUNT)
     {
-        const float gate = seq->in_step != NULL ? seq->in_step[i] : 0.0f;
-        const int trig = gate > 0.0f;
-        
-        if (trig != seq->trig)
+        const int trig = seq->in_step[i] > 0.0f;
+        if (trig && !seq->trig)
         {
-            if (trig)
-            {
-                seq->step = (seq->step + 1) % 8;
-            }
-            seq->trig = trig;
+            seq->step = (seq->step + 1) % 8;
         }
-        
-        seq->out_cv[i] = (&seq->in_cv_0)[seq->step];
+        seq->trig = trig;
+
+        const size_t end = tr_buf_find_gate_edge(seq->in_step, i + 1, trig);
+        tr_buf_fill_run(seq->out_cv, i, end, (&seq->in_cv_0)[seq->step]);
+        i = end;
     }
 }
 
+tr_module_update_fn tr_seq8_specialize(const tr_seq8_t* seq)
+{
+    if (seq->in_step == NULL)
+    {
+        return (tr_module_update_fn)tr_seq8_update_idle;
+    }
+    return (tr_module_update_fn)tr_seq8_update;
+}
+
 //
 // tr_adsr_t
 //
 
 enum
 {
-    TR_LUT_ADSR_DECAY,
+    TR_ADSR_STATE_ATTACK,
+    TR_ADSR_STATE_DECAY,
+    TR_ADSR_STATE_SUSTAIN,
+    TR_ADSR_STATE_RELEASE,
 };
 
-
-
-void tr_adsr_lut_init(void)
+// Per-sample rate of a one-pole that covers 1 - 1/2 of the distance to its
+// target in t_sec: 1 - 2^(-1 / (t_sec * fs)). The series avoids the
+// cancellation of 1 - 2^-y for long times, where y is tiny.
+static float tr_adsr_time_to_rate(float t_sec)
 {
+    const float z = (float)TR_LN2 / (fmaxf(t_sec, 1e-6f) * (float)TR_SAMPLE_RATE);
+    if (z < 1e-2f)
+    {
+        return z * (1.0f - z * (0.5f - z * (1.0f / 6.0f)));
+    }
+    return 1.0f - tr_expf_precise(-z);
+}
 
+// Knob in [0, 1] to a time in [t_min, t_max], exponential across decades,
+// with the knob raised to 'skew' to compress the low end.
+static float tr_adsr_knob_to_time(float x, float t_min, float t_max, float skew)
+{
+    const float xs = x > 0.0f ? tr_expf_precise(skew * tr_logf_precise(x)) : 0.0f;
+    return t_min * tr_expf_precise(xs * tr_logf_precise(t_max / t_min));
 }
 
+// Knob position to per-sample rate tables, built once by tr_adsr_lut_init
+// so the update doesn't go through powf and exp2f for every knob.
 enum
 {
-    TR_ADSR_STATE_ATTACK,
-    TR_ADSR_STATE_DECAY,
-    TR_ADSR_STATE_SUSTAIN,
-    TR_ADSR_STATE_RELEASE,
+    TR_LUT_ADSR_ATTACK,
+    TR_LUT_ADSR_DECAY,
+    TR_LUT_ADSR_RELEASE,
+    TR_LUT_COUNT,
 };
 
-static inline float tr__time_to_coeff(float t_sec)
-{
-    // t_sec == 0 → coeff 0 for instant jump
-    //if (t_sec <= 0.0f) return 0.0f;
-    float c = tr_exp2f(-1.0f / (t_sec * (float)TR_SAMPLE_RATE));
-    // numerical guard
-    return float_clamp(c, 0.0f, 1.0f);
-}
+#define TR_LUT_SIZE (256)
+
+static float g_tr_luts[TR_LUT_COUNT][TR_LUT_SIZE + 1];
+
+// The decay knob is a time in seconds, its rate goes like 1/time and
+// wouldn't interpolate well near 0. Its table is indexed by log(time)
+// over the knob range [0.001, 1] instead.
+#define TR_LUT_ADSR_DECAY_LOG_MIN (-6.90775528f) // ln(0.001)
 
-static inline float map_knob_exp(float x, float t_min, float t_max, float skew)
+static inline float tr_lut_adsr_decay_index(float t_sec)
 {
-    // raise the knob to 'skew' to compress the low end
-    float xs = tr_powf(x, skew);
-    // exponential mapping across decades
-    float ratio = t_max / fmaxf(t_min, 1e-9f);
-    return t_min * tr_powf(ratio, xs);
+    return 1.0f - tr_logf_precise(t_sec) * (1.0f / TR_LUT_ADSR_DECAY_LOG_MIN);
 }
 
-#define TR_ADSR_EPSILON (1e-5f)
-
-void tr_adsr_update(tr_adsr_t* adsr)
+void tr_adsr_lut_init(void)
 {
-    if (adsr->in_gate == NULL)
+    for (int i = 0; i <= TR_LUT_SIZE; ++i)
     {
-        memset(adsr->out_env, 0, sizeof(adsr->out_env));
-        return;
+        const float x = (float)i / TR_LUT_SIZE;
+        const float decay = tr_expf_precise((1.0f - x) * TR_LUT_ADSR_DECAY_LOG_MIN);
+
+        g_tr_luts[TR_LUT_ADSR_ATTACK][i] = tr_adsr_time_to_rate(tr_adsr_knob_to_time(x, 0.0005f, 10.0f, 1.5f));
+        g_tr_luts[TR_LUT_ADSR_DECAY][i] = tr_adsr_time_to_rate(decay);
+        g_tr_luts[TR_LUT_ADSR_RELEASE][i] = tr_adsr_time_to_rate(tr_adsr_knob_to_time(x, 0.0005f, 10.0f, 1.2f));
     }
+}
 
-    const float a_coeff = tr__time_to_coeff(map_knob_exp(adsr->in_attack, 0.0005f, 10.0f, 1.5f));
-    const float d_coeff = tr__time_to_coeff(adsr->in_decay);
-    const float r_coeff = tr__time_to_coeff(map_knob_exp(adsr->in_release, 0.0005f, 10.0f, 1.2f));
+// x in [0, 1], linearly interpolated
+static inline float tr_lut_lookup(int lut, float x)
+{
+    const float pos = float_clamp(x, 0.0f, 1.0f) * TR_LUT_SIZE;
+    const int i = (int)pos < TR_LUT_SIZE ? (int)pos : TR_LUT_SIZE - 1;
+    const float* table = g_tr_luts[lut];
+    return table[i] + (pos - (float)i) * (table[i + 1] - table[i]);
+}
 
-    float value = adsr->value;
-    int state = adsr->state;
-    int gate = adsr->gate;
+#define TR_ADSR_EPSILON (1e-5f)
 
-    for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
-    {
-        const int g = adsr->in_gate[i] > 0.0f;
-        const int edge = g != gate;
-        const int note_on = edge && g;
-        const int note_off = edge && !g;
-        
-        gate = g;
+typedef struct tr_adsr_rates
+{
+    float attack;
+    float decay;
+    float release;
+} tr_adsr_rates_t;
+
+// Runs the stages over [i, end), a stretch where the gate doesn't change.
+// Each stage is its own loop: attack and decay stop at their target,
+// sustain and release last until the end of the stretch.
+static void tr_adsr_run(tr_adsr_t* adsr, const tr_adsr_rates_t* rates, float* value_ptr, int* state_ptr, size_t i, size_t end)
+{
+    const float sustain = adsr->in_sustain;
+    float* out = adsr->out_env;
+    float value = *value_ptr;
+    int state = *state_ptr;
 
-        if (note_on)    state = TR_ADSR_STATE_ATTACK;
-        if (note_off)   state = TR_ADSR_STATE_RELEASE;
-        
+    while (i < end)
+    {
         switch (state)
         {
             case TR_ADSR_STATE_ATTACK:
-                value += (1.0f - value) * (1.0f - a_coeff);
-                if (value >= 1.0f - TR_ADSR_EPSILON) {
-                    value = 1.0f;
-                    state = TR_ADSR_STATE_DECAY;
+                while (i < end)
+                {
+                    value += (1.0f - value) * rates->attack;
+                    if (value >= 1.0f - TR_ADSR_EPSILON)
+                    {
+                        value = 1.0f;
+                        state = TR_ADSR_STATE_DECAY;
+                    }
+                    value = float_clamp(value, 0.0f, 1.0f);
+                    out[i++] = value;
+                    if (state != TR_ADSR_STATE_ATTACK) break;
                 }
                 break;
             case TR_ADSR_STATE_DECAY:
-                value += (adsr->in_sustain - value) * (1.0f - d_coeff);
-                if (tr_fabsf(value - adsr->in_sustain) <= TR_ADSR_EPSILON) {
-                    value = adsr->in_sustain;
-                    adsr->state = TR_ADSR_STATE_SUSTAIN;
+                while (i < end)
+                {
+                    value += (sustain - value) * rates->decay;
+                    if (tr_fabsf(value - sustain) <= TR_ADSR_EPSILON)
+                    {
+                        value = sustain;
+                        state = TR_ADSR_STATE_SUSTAIN;
+                    }
+                    value = float_clamp(value, 0.0f, 1.0f);
+                    out[i++] = value;
+                    if (state != TR_ADSR_STATE_DECAY) break;
                 }
                 break;
             case TR_ADSR_STATE_SUSTAIN:
-                value += (adsr->in_sustain - value) * 0.001f;
+                for (; i < end; ++i)
+                {
+                    value += (sustain - value) * 0.001f;
+                    value = float_clamp(value, 0.0f, 1.0f);
+                    out[i] = value;
+                }
                 break;
             case TR_ADSR_STATE_RELEASE:
-                value += (0.0f - value) * (1.0f - r_coeff);
+                for (; i < end; ++i)
+                {
+                    value -= value * rates->release;
+                    value = float_clamp(value, 0.0f, 1.0f);
+                    out[i] = value;
+                }
                 break;
         }
-        
-        value = fminf(value, 1.0f);
-        value = fmaxf(value, 0.0f);
+    }
+
+    *value_ptr = value;
+    *state_ptr = state;
+}
 
-        adsr->out_env[i] = value;
+void tr_adsr_update(tr_adsr_t* adsr)
+{
+    if (adsr->in_gate == NULL)
+    {
+        memset(adsr->out_env, 0, sizeof(float) * TR_SAMPLE_COUNT);
+        return;
+    }
+
+    const tr_adsr_rates_t rates = {
+        .attack = tr_lut_lookup(TR_LUT_ADSR_ATTACK, adsr->in_attack),
+        .decay = tr_lut_lookup(TR_LUT_ADSR_DECAY, tr_lut_adsr_decay_index(adsr->in_decay)),
+        .release = tr_lut_lookup(TR_LUT_ADSR_RELEASE, adsr->in_release),
+    };
+
+    float value = adsr->value;
+    int state = adsr->state;
+    int gate = adsr->gate;
+
+    size_t i = 0;
+    while (i < TR_SAMPLE_COUNT)
+    {
+        // a gate edge switches the stage on the sample it happens
+        const int g = adsr->in_gate[i] > 0.0f;
+        if (g != gate)
+        {
+            gate = g;
+            state = g ? TR_ADSR_STATE_ATTACK : TR_ADSR_STATE_RELEASE;
+        }
+
+        const size_t end = tr_buf_find_gate_edge(adsr->in_gate, i + 1, gate);
+        tr_adsr_run(adsr, &rates, &value, &state, i, end);
+        i = end;
     }
 
     adsr->value = value;
@@ -218,31 +510,35 @@ void tr_vca_update(tr_vca_t* vca)
     if (vca->in_audio == NULL || 
         vca->in_cv == NULL)
     {
-        memset(vca->out_mix, 0, sizeof(vca->out_mix));
+        memset(vca->out_mix, 0, sizeof(float) * TR_SAMPLE_COUNT);
         return;
     }
 
-    for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
-    {
-        vca->out_mix[i] = vca->in_audio[i] * vca->in_cv[i];
-    }
+    tr_buf_mul(vca->out_mix, vca->in_audio, vca->in_cv);
 }
 
 //
 // tr_lp_t
 //
 
-static inline float tpt_lp1_process(float* z, float x, float cutoffHz)
+// Argument of the tan in the TPT coefficient: g = tan(pi * fc / fs)
+static inline float tpt_lp1_warp(float cutoffHz)
 {
     // Safety: clamp cutoff (avoid Nyquist and negatives)
     //const float nyq = 0.5f * TR_SAMPLE_RATE;
-    if (cutoffHz < 0.0f) cutoffHz = 0.0f;
-    if (cutoffHz > 0.495f * TR_SAMPLE_RATE) cutoffHz = 0.495f * TR_SAMPLE_RATE;
+    cutoffHz = cutoffHz < 0.0f ? 0.0f : cutoffHz;
+    cutoffHz = cutoffHz > 0.495f * TR_SAMPLE_RATE ? 0.495f * TR_SAMPLE_RATE : cutoffHz;
 
-    // TPT coefficient: g = tan(pi * fc / fs)
-    const float g = tr_tanf(TR_PI * cutoffHz / TR_SAMPLE_RATE);
-    const float a = g / (1.0f + g);      // bilinear transform form
+    return (float)TR_PI * cutoffHz / TR_SAMPLE_RATE;
+}
 
+static inline float tpt_lp1_coef(float g)
+{
+    return g / (1.0f + g);      // bilinear transform form
+}
+
+static inline float tpt_lp1_process(float* z, float x, float a)
+{
     // Zero-denormal trick: add tiny dc to break subnormals
     const float x_nd = x + 1e-24f;
 
@@ -268,51 +564,530 @@ static inline float control_to_hz(float u, float minHz, float maxHz, float fs)
     return fc;
 }
 
+static inline float tpt_lp1_coef_from_control(float u)
+{
+    const float cutoff = control_to_hz(u, 1.0f, 20000.0f, TR_SAMPLE_RATE);
+    return tpt_lp1_coef(tr_tanf(tpt_lp1_warp(cutoff)));
+}
+
+// Same as tpt_lp1_coef_from_control for a whole block of control values, a
+// log, an exp and a tan per sample is most of the filter's cost.
+static void tpt_lp1_coef_from_control_buf(float* a, const float* u)
+{
+    const float logMin = tr_logf(1.0f);
+    const float logMax = tr_logf(20000.0f);
+
+    for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
+    {
+        const float v = u[i] < 0.0f ? 0.0f : (u[i] > 1.0f ? 1.0f : u[i]);
+        a[i] = logMin + (logMax - logMin) * v;
+    }
+
+    tr_expf_buf(a, a, TR_SAMPLE_COUNT);
+
+    for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
+    {
+        a[i] = tpt_lp1_warp(a[i]);
+    }
+
+    tr_tanf_buf(a, a, TR_SAMPLE_COUNT);
+
+    for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
+    {
+        a[i] = tpt_lp1_coef(a[i]);
+    }
+}
+
+static void tr_lp_filter_buf(tr_lp_t* lp, const float* a)
+{
+    for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
+    {
+        lp->out_audio[i] = tpt_lp1_process(&lp->z, lp->in_audio[i], a[i]);
+    }
+}
+
+static void tr_lp_update_silent(tr_lp_t* lp)
+{
+    memset(lp->out_audio, 0, sizeof(float) * TR_SAMPLE_COUNT);
+}
+
+// Cutoff doesn't move during the block, control_to_hz runs once.
+static void tr_lp_update_fixed(tr_lp_t* lp, float cut)
+{
+    const float a = tpt_lp1_coef_from_control(cut);
+
+    for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
+    {
+        lp->out_audio[i] = tpt_lp1_process(&lp->z, lp->in_audio[i], a);
+    }
+
+    lp->cut_last = cut;
+    lp->a_last = a;
+}
+
+// Largest error allowed between the cutoff control and its linear
+// interpolation from the control-rate points, in control units (~0.2
+// semitone over the 1Hz-20kHz range).
+#define TR_LP_CONTROL_TOLERANCE (1e-3f)
+
+// True when the control is close enough to a straight line between every
+// TR_LP_CONTROL_RATE-th sample, from is the control at the end of the last
+// block. Knob ramps always pass, LFOs and envelopes mostly do, audio doesn't.
+static bool tr_lp_is_control_rate(const float* cut, float from)
+{
+    float error = 0.0f;
+
+    for (size_t k = 0; k < TR_SAMPLE_COUNT; k += TR_LP_CONTROL_RATE)
+    {
+        const float c0 = k == 0 ? from : cut[k - 1];
+        const float dc = (cut[k + TR_LP_CONTROL_RATE - 1] - c0) * (1.0f / TR_LP_CONTROL_RATE);
+
+        for (size_t j = 0; j < TR_LP_CONTROL_RATE; ++j)
+        {
+            error = fmaxf(error, tr_fabsf(cut[k + j] - (c0 + dc * (float)(j + 1))));
+        }
+    }
+
+    return error <= TR_LP_CONTROL_TOLERANCE;
+}
+
+// Filters with a cutoff control per sample, the coefficients are computed
+// at the control rate when the control allows it.
+static void tr_lp_update_control(tr_lp_t* lp, const float* cut)
+{
+    tr_buf a;
+
+    // at rate 1 every sample is a control point, same as the exact path
+    if (TR_LP_CONTROL_RATE > 1 && lp->a_last > 0.0f && tr_lp_is_control_rate(cut, lp->cut_last))
+    {
+        float from = lp->a_last;
+        for (size_t k = 0; k < TR_SAMPLE_COUNT; k += TR_LP_CONTROL_RATE)
+        {
+            const float to = tpt_lp1_coef_from_control(cut[k + TR_LP_CONTROL_RATE - 1]);
+            const float step = (to - from) * (1.0f / TR_LP_CONTROL_RATE);
+
+            for (size_t j = 0; j < TR_LP_CONTROL_RATE; ++j)
+            {
+                a[k + j] = tr_smooth_at(from, step, j);
+            }
+            from = to;
+        }
+    }
+    else
+    {
+        tpt_lp1_coef_from_control_buf(a, cut);
+    }
+
+    tr_lp_filter_buf(lp, a);
+
+    lp->cut_last = cut[TR_SAMPLE_COUNT - 1];
+    lp->a_last = a[TR_SAMPLE_COUNT - 1];
+}
+
+// in_cut0 or in_cut_mul is moving, they are ramped over the block
+static void tr_lp_update_ramp(tr_lp_t* lp, float from, float step, float mul_from, float mul_step)
+{
+    tr_buf cut;
+    for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
+    {
+        cut[i] = tr_smooth_at(from, step, i);
+    }
+    if (lp->in_cut != NULL)
+    {
+        tr_buf_madd_ramp(cut, lp->in_cut, mul_from, mul_step);
+    }
+
+    tr_lp_update_control(lp, cut);
+}
+
+static void tr_lp_update_knob(tr_lp_t* lp)
+{
+    float from, step;
+    if (tr_smooth(&lp->cut0_smooth, lp->in_cut0, &from, &step))
+    {
+        tr_lp_update_ramp(lp, from, step, 0.0f, 0.0f);
+        return;
+    }
+
+    tr_lp_update_fixed(lp, lp->in_cut0);
+}
+
 void tr_lp_update(tr_lp_t* lp)
 {
-    if (lp->in_audio == NULL)
+    float from, step;
+    float mul_from, mul_step;
+    const bool cut0_moved = tr_smooth_ramp(&lp->cut0_smooth, lp->in_cut0, &from, &step);
+    const bool cut_mul_moved = tr_smooth_ramp(&lp->cut_mul_smooth, lp->in_cut_mul, &mul_from, &mul_step);
+    if (cut0_moved || cut_mul_moved)
+    {
+        tr_lp_update_ramp(lp, from, step, mul_from, mul_step);
+        return;
+    }
+
+    if (tr_input_is_constant(lp->in_cut))
     {
-        memset(lp->out_audio, 0, sizeof(float) * TR_SAMPLE_COUNT);
+        tr_lp_update_fixed(lp, lp->in_cut0 + lp->in_cut[0] * lp->in_cut_mul);
         return;
     }
 
+    tr_buf cut;
     for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
     {
-        float cut = lp->in_cut0;
-        if (lp->in_cut != NULL) cut += lp->in_cut[i] * lp->in_cut_mul;
+        cut[i] = lp->in_cut0 + lp->in_cut[i] * lp->in_cut_mul;
+    }
 
-        const float cutoff = control_to_hz(cut, 1.0f, 20000.0f, TR_SAMPLE_RATE);
+    tr_lp_update_control(lp, cut);
+}
 
-        const float y = tpt_lp1_process(&lp->z, lp->in_audio[i], cutoff);
-        
-        lp->out_audio[i] = y;
+tr_module_update_fn tr_lp_specialize(const tr_lp_t* lp)
+{
+    if (lp->in_audio == NULL)
+    {
+        return (tr_module_update_fn)tr_lp_update_silent;
+    }
+    if (lp->in_cut == NULL)
+    {
+        return (tr_module_update_fn)tr_lp_update_knob;
     }
+    return (tr_module_update_fn)tr_lp_update;
+}
+
+//
+// tr_svf_t, tr_ladder_t
+//
+// Recursive filters don't vectorize along time, so these process up to
+// TR_SCHEDULE_BATCH_WIDTH instances side by side instead: lane k of every
+// tr_v4 is instance k. The audio is read 4 samples at a time from each
+// instance and transposed, so each vector holds one sample of every lane.
+//
+
+_Static_assert(TR_SCHEDULE_BATCH_WIDTH == 4, "one filter per tr_v4 lane");
+
+// Samples between two cutoff evaluations, the prewarped cutoff is
+// interpolated in between
+#define TR_FILTER_CONTROL_RATE (16)
+
+static const tr_buf g_tr_silence;
+
+typedef struct tr_filter_lanes
+{
+    size_t count;
+    const float* audio[4];
+    const float* cut[4]; // NULL when unplugged
+    // knob ramps, see tr_smooth
+    float cut0[4];
+    float cut0_step[4];
+    float cut_mul[4];
+    float cut_mul_step[4];
+    float g_last[4];
+} tr_filter_lanes_t;
+
+static void tr_filter_lane_init(tr_filter_lanes_t* lanes, size_t k, tr_input audio, tr_input cut, float g_last)
+{
+    lanes->audio[k] = audio != NULL ? audio : g_tr_silence;
+    lanes->cut[k] = cut;
+    lanes->g_last[k] = g_last;
+}
+
+// Ramp of a knob of lane k into from[k] and step[k]. Like its cutoff (see
+// tr_filter_lanes_g_start), a lane that has never run starts on its knobs.
+static void tr_filter_lane_knob(float* from, float* step, size_t k, float* state, float knob, float g_last)
+{
+    if (g_last == 0.0f)
+    {
+        *state = knob;
+    }
+    tr_smooth_ramp(state, knob, &from[k], &step[k]);
+}
+
+// Prewarped cutoff g = tan(pi * fc / fs) of every lane at sample i. Only
+// runs at the control rate, so it affords the precise tan, the resonance
+// peak would be off tune with the fast one.
+static tr_v4 tr_filter_lanes_g(const tr_filter_lanes_t* lanes, size_t i)
+{
+    float g[4];
+    for (size_t k = 0; k < 4; ++k)
+    {
+        const float cut0 = tr_smooth_at(lanes->cut0[k], lanes->cut0_step[k], i);
+        const float cut_mul = tr_smooth_at(lanes->cut_mul[k], lanes->cut_mul_step[k], i);
+        const float cut = cut0 + (lanes->cut[k] != NULL ? lanes->cut[k][i] * cut_mul : 0.0f);
+        g[k] = tr_tanf_precise(tpt_lp1_warp(control_to_hz(cut, 1.0f, 20000.0f, TR_SAMPLE_RATE)));
+    }
+    return tr_v4_set(g[0], g[1], g[2], g[3]);
+}
+
+// g at the start of the block, a lane that has never run starts on its
+// first control point instead of ramping up from 0
+static tr_v4 tr_filter_lanes_g_start(const tr_filter_lanes_t* lanes)
+{
+    const tr_v4 g_last = tr_v4_load(lanes->g_last);
+    return tr_v4_select_gt(g_last, tr_v4_set1(0.0f), g_last, tr_filter_lanes_g(lanes, TR_FILTER_CONTROL_RATE - 1));
+}
+
+// x[j] = sample i + j of every lane
+static inline void tr_filter_load(const tr_filter_lanes_t* lanes, size_t i, tr_v4 x[4])
+{
+    for (size_t k = 0; k < 4; ++k)
+    {
+        x[k] = tr_v4_load(lanes->audio[k] + i);
+    }
+    tr_v4_transpose(x);
+}
+
+// Inverse of tr_filter_load, only the lanes in use are written
+static inline void tr_filter_store(float* const out[4], size_t count, size_t i, tr_v4 y[4])
+{
+    tr_v4_transpose(y);
+    for (size_t k = 0; k < count; ++k)
+    {
+        tr_v4_store(out[k] + i, y[k]);
+    }
+}
+
+// Andrew Simper's trapezoidal SVF
+void tr_svf_update_batch(tr_svf_t** svfs, size_t count)
+{
+    tr_filter_lanes_t lanes = {count};
+    float* out_lp[4];
+    float* out_bp[4];
+    float* out_hp[4];
+    float ic1eq[4] = {0};
+    float ic2eq[4] = {0};
+    float res[4] = {0};
+    float res_step[4] = {0};
+
+    for (size_t k = 0; k < count; ++k)
+    {
+        tr_svf_t* svf = svfs[k];
+        tr_filter_lane_init(&lanes, k, svf->in_audio, svf->in_cut, svf->g_last);
+        tr_filter_lane_knob(lanes.cut0, lanes.cut0_step, k, &svf->cut0_smooth, svf->in_cut0, svf->g_last);
+        tr_filter_lane_knob(lanes.cut_mul, lanes.cut_mul_step, k, &svf->cut_mul_smooth, svf->in_cut_mul, svf->g_last);
+        tr_filter_lane_knob(res, res_step, k, &svf->res_smooth, svf->in_res, svf->g_last);
+        out_lp[k] = svf->out_lp;
+        out_bp[k] = svf->out_bp;
+        out_hp[k] = svf->out_hp;
+        ic1eq[k] = svf->ic1eq;
+        ic2eq[k] = svf->ic2eq;
+    }
+    for (size_t k = count; k < 4; ++k)
+    {
+        tr_filter_lane_init(&lanes, k, NULL, NULL, 0.0f);
+    }
+
+    const tr_v4 one = tr_v4_set1(1.0f);
+    const tr_v4 two = tr_v4_set1(2.0f);
+    const tr_v4 denormal = tr_v4_set1(1e-24f);
+
+    // damping, 2 (no resonance) down to 0.04, ramped like res
+    const tr_v4 damp_from = tr_v4_sub(two, tr_v4_mul(tr_v4_load(res), tr_v4_set1(1.96f)));
+    const tr_v4 damp_step = tr_v4_mul(tr_v4_load(res_step), tr_v4_set1(-1.96f));
+
+    tr_v4 ic1 = tr_v4_load(ic1eq);
+    tr_v4 ic2 = tr_v4_load(ic2eq);
+    tr_v4 g = tr_filter_lanes_g_start(&lanes);
+
+    for (size_t s = 0; s < TR_SAMPLE_COUNT; s += TR_FILTER_CONTROL_RATE)
+    {
+        const tr_v4 g_to = tr_filter_lanes_g(&lanes, s + TR_FILTER_CONTROL_RATE - 1);
+        const tr_v4 dg = tr_v4_mul(tr_v4_sub(g_to, g), tr_v4_set1(1.0f / TR_FILTER_CONTROL_RATE));
+
+        for (size_t i = s; i < s + TR_FILTER_CONTROL_RATE; i += 4)
+        {
+            tr_v4 x[4], lp[4], bp[4], hp[4];
+            tr_filter_load(&lanes, i, x);
+
+            for (size_t j = 0; j < 4; ++j)
+            {
+                g = tr_v4_add(g, dg);
+
+                const tr_v4 damp = tr_v4_add(damp_from, tr_v4_mul(damp_step, tr_v4_set1((float)(i + j + 1))));
+                const tr_v4 a1 = tr_v4_div(one, tr_v4_add(one, tr_v4_mul(g, tr_v4_add(g, damp))));
+                const tr_v4 a2 = tr_v4_mul(g, a1);
+                const tr_v4 a3 = tr_v4_mul(g, a2);
+
+                const tr_v4 v0 = tr_v4_add(x[j], denormal);
+                const tr_v4 v3 = tr_v4_sub(v0, ic2);
+                const tr_v4 v1 = tr_v4_add(tr_v4_mul(a1, ic1), tr_v4_mul(a2, v3));
+                const tr_v4 v2 = tr_v4_add(ic2, tr_v4_add(tr_v4_mul(a2, ic1), tr_v4_mul(a3, v3)));
+                ic1 = tr_v4_sub(tr_v4_mul(two, v1), ic1);
+                ic2 = tr_v4_sub(tr_v4_mul(two, v2), ic2);
+
+                lp[j] = v2;
+                bp[j] = v1;
+                hp[j] = tr_v4_sub(tr_v4_sub(v0, tr_v4_mul(damp, v1)), v2);
+            }
+
+            tr_filter_store(out_lp, count, i, lp);
+            tr_filter_store(out_bp, count, i, bp);
+            tr_filter_store(out_hp, count, i, hp);
+        }
+
+        g = g_to;
+    }
+
+    float g_last[4];
+    tr_v4_store(ic1eq, ic1);
+    tr_v4_store(ic2eq, ic2);
+    tr_v4_store(g_last, g);
+    for (size_t k = 0; k < count; ++k)
+    {
+        svfs[k]->ic1eq = ic1eq[k];
+        svfs[k]->ic2eq = ic2eq[k];
+        svfs[k]->g_last = g_last[k];
+    }
+}
+
+void tr_svf_update(tr_svf_t* svf)
+{
+    tr_svf_update_batch(&svf, 1);
+}
+
+// Four TPT one-poles in a loop. The zero-delay feedback is solved in closed
+// form: with G = g / (1 + g) the last stage is y4 = G^4 u + S, where S only
+// depends on the stage states, and u = x - k y4.
+void tr_ladder_update_batch(tr_ladder_t** ladders, size_t count)
+{
+    tr_filter_lanes_t lanes = {count};
+    float* out_audio[4];
+    float state[4][4] = {0};
+    float res[4] = {0};
+    float res_step[4] = {0};
+
+    for (size_t k = 0; k < count; ++k)
+    {
+        tr_ladder_t* ladder = ladders[k];
+        tr_filter_lane_init(&lanes, k, ladder->in_audio, ladder->in_cut, ladder->g_last);
+        tr_filter_lane_knob(lanes.cut0, lanes.cut0_step, k, &ladder->cut0_smooth, ladder->in_cut0, ladder->g_last);
+        tr_filter_lane_knob(lanes.cut_mul, lanes.cut_mul_step, k, &ladder->cut_mul_smooth, ladder->in_cut_mul, ladder->g_last);
+        tr_filter_lane_knob(res, res_step, k, &ladder->res_smooth, ladder->in_res, ladder->g_last);
+        out_audio[k] = ladder->out_audio;
+        state[0][k] = ladder->s1;
+        state[1][k] = ladder->s2;
+        state[2][k] = ladder->s3;
+        state[3][k] = ladder->s4;
+    }
+    for (size_t k = count; k < 4; ++k)
+    {
+        tr_filter_lane_init(&lanes, k, NULL, NULL, 0.0f);
+    }
+
+    const tr_v4 one = tr_v4_set1(1.0f);
+    const tr_v4 denormal = tr_v4_set1(1e-24f);
+
+    // feedback, self-oscillation starts at 4, ramped like res
+    const tr_v4 fb_from = tr_v4_mul(tr_v4_load(res), tr_v4_set1(3.96f));
+    const tr_v4 fb_step = tr_v4_mul(tr_v4_load(res_step), tr_v4_set1(3.96f));
+
+    tr_v4 s1 = tr_v4_load(state[0]);
+    tr_v4 s2 = tr_v4_load(state[1]);
+    tr_v4 s3 = tr_v4_load(state[2]);
+    tr_v4 s4 = tr_v4_load(state[3]);
+    tr_v4 g = tr_filter_lanes_g_start(&lanes);
+
+    for (size_t s = 0; s < TR_SAMPLE_COUNT; s += TR_FILTER_CONTROL_RATE)
+    {
+        const tr_v4 g_to = tr_filter_lanes_g(&lanes, s + TR_FILTER_CONTROL_RATE - 1);
+        const tr_v4 dg = tr_v4_mul(tr_v4_sub(g_to, g), tr_v4_set1(1.0f / TR_FILTER_CONTROL_RATE));
+
+        for (size_t i = s; i < s + TR_FILTER_CONTROL_RATE; i += 4)
+        {
+            tr_v4 x[4];
+            tr_filter_load(&lanes, i, x);
+
+            for (size_t j = 0; j < 4; ++j)
+            {
+                g = tr_v4_add(g, dg);
+
+                const tr_v4 fb = tr_v4_add(fb_from, tr_v4_mul(fb_step, tr_v4_set1((float)(i + j + 1))));
+                const tr_v4 G = tr_v4_div(g, tr_v4_add(one, g));
+                const tr_v4 G2 = tr_v4_mul(G, G);
+                const tr_v4 G4 = tr_v4_mul(G2, G2);
+                const tr_v4 b = tr_v4_sub(one, G);
+
+                // S = (1 - G) (G^3 s1 + G^2 s2 + G s3 + s4)
+                const tr_v4 S = tr_v4_mul(b, tr_v4_add(tr_v4_mul(G, tr_v4_add(tr_v4_mul(G, tr_v4_add(tr_v4_mul(G, s1), s2)), s3)), s4));
+
+                const tr_v4 v0 = tr_v4_add(x[j], denormal);
+                const tr_v4 y4 = tr_v4_div(tr_v4_add(tr_v4_mul(G4, v0), S), tr_v4_add(one, tr_v4_mul(fb, G4)));
+                const tr_v4 u = tr_v4_sub(v0, tr_v4_mul(fb, y4));
+
+                tr_v4 v, y;
+                v = tr_v4_mul(tr_v4_sub(u, s1), G); y = tr_v4_add(v, s1); s1 = tr_v4_add(y, v);
+                v = tr_v4_mul(tr_v4_sub(y, s2), G); y = tr_v4_add(v, s2); s2 = tr_v4_add(y, v);
+                v = tr_v4_mul(tr_v4_sub(y, s3), G); y = tr_v4_add(v, s3); s3 = tr_v4_add(y, v);
+                v = tr_v4_mul(tr_v4_sub(y, s4), G); y = tr_v4_add(v, s4); s4 = tr_v4_add(y, v);
+
+                x[j] = y;
+            }
+
+            tr_filter_store(out_audio, count, i, x);
+        }
+
+        g = g_to;
+    }
+
+    float g_last[4];
+    tr_v4_store(state[0], s1);
+    tr_v4_store(state[1], s2);
+    tr_v4_store(state[2], s3);
+    tr_v4_store(state[3], s4);
+    tr_v4_store(g_last, g);
+    for (size_t k = 0; k < count; ++k)
+    {
+        ladders[k]->s1 = state[0][k];
+        ladders[k]->s2 = state[1][k];
+        ladders[k]->s3 = state[2][k];
+        ladders[k]->s4 = state[3][k];
+        ladders[k]->g_last = g_last[k];
+    }
+}
+
+void tr_ladder_update(tr_ladder_t* ladder)
+{
+    tr_ladder_update_batch(&ladder, 1);
 }
 
 //
 // tr_mixer_t
 //
 
-static void tr_mixer_accum(float* mix, const float* in, float mul)
+static void tr_mixer_input(float* mix, const float* in, float* vol_smooth, float vol)
 {
-    for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
+    float from, step;
+    const bool ramp = tr_smooth(vol_smooth, vol, &from, &step);
+
+    if (in == NULL)
     {
-        mix[i] += in[i] * mul;
+        return;
+    }
+
+    if (ramp)
+    {
+        tr_buf_madd_ramp(mix, in, from, step);
+    }
+    else
+    {
+        tr_buf_madd(mix, in, vol);
     }
 }
 
 void tr_mixer_update(tr_mixer_t* mixer)
 {
-    memset(mixer->out_mix, 0, sizeof(mixer->out_mix));
+    memset(mixer->out_mix, 0, sizeof(float) * TR_SAMPLE_COUNT);
 
-    if (mixer->in_0 != NULL) tr_mixer_accum(mixer->out_mix, mixer->in_0, mixer->in_vol0);
-    if (mixer->in_1 != NULL) tr_mixer_accum(mixer->out_mix, mixer->in_1, mixer->in_vol1);
-    if (mixer->in_2 != NULL) tr_mixer_accum(mixer->out_mix, mixer->in_2, mixer->in_vol2);
-    if (mixer->in_3 != NULL) tr_mixer_accum(mixer->out_mix, mixer->in_3, mixer->in_vol3);
+    tr_mixer_input(mixer->out_mix, mixer->in_0, &mixer->vol0_smooth, mixer->in_vol0);
+    tr_mixer_input(mixer->out_mix, mixer->in_1, &mixer->vol1_smooth, mixer->in_vol1);
+    tr_mixer_input(mixer->out_mix, mixer->in_2, &mixer->vol2_smooth, mixer->in_vol2);
+    tr_mixer_input(mixer->out_mix, mixer->in_3, &mixer->vol3_smooth, mixer->in_vol3);
 
-    for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
+    float from, step;
+    if (tr_smooth(&mixer->vol_final_smooth, mixer->in_vol_final, &from, &step))
     {
-        mixer->out_mix[i] *= mixer->in_vol_final;
+        tr_buf_scale_ramp(mixer->out_mix, mixer->out_mix, from, step);
+    }
+    else
+    {
+        tr_buf_scale(mixer->out_mix, mixer->out_mix, mixer->in_vol_final);
     }
 
 #if 0
@@ -335,6 +1110,25 @@ static inline float tr_onepole_a_from_fc(float fc)
     return tr_expf(-2.0f * (float)TR_PI * fc / (float)TR_SAMPLE_RATE);
 }
 
+// Counter-based: sample n is a hash of (seed, n), there is no state carried
+// from one sample to the next so the white noise loop vectorizes. The
+// counter walks a Weyl sequence and goes through the lowbias32 finalizer.
+static inline uint32_t tr_noise_hash(uint32_t key, uint32_t counter)
+{
+    uint32_t x = counter * 0x9e3779b9u + key;
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+void tr_noise_seed(tr_noise_t* noise, size_t index)
+{
+    noise->seed = (int)tr_noise_hash(0x6e6f6973u, (uint32_t)index);
+}
+
 void tr_noise_update(tr_noise_t* noise)
 {
     const float a_red  = tr_onepole_a_from_fc(TR_NOISE_RED_FC_HZ);
@@ -342,16 +1136,24 @@ void tr_noise_update(tr_noise_t* noise)
     //const float a_hp   = tr_onepole_a_from_fc(TR_NOISE_BLUE_HP_FC_HZ);
     //const float a_tame = tr_onepole_a_from_fc(TR_NOISE_BLUE_TAME_FC_HZ);
 
+    const uint32_t key = (uint32_t)noise->seed;
+    const uint32_t counter = (uint32_t)noise->rng;
+
+    // signed conversion, the top bit is the sign: [-1, 1) without a divide
     for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
     {
-        noise->rng = (uint32_t)noise->rng * 1664525u + 1013904223u;
-        const float w = ((uint32_t)noise->rng / (float)UINT32_MAX) * 2.0f - 1.0f;
-
-        noise->red_state = a_red * noise->red_state + b_red * w;
+        const int32_t h = (int32_t)tr_noise_hash(key, counter + (uint32_t)i);
+        noise->out_white[i] = (float)h * (1.0f / 2147483648.0f);
+    }
+    noise->rng = (int)(counter + TR_SAMPLE_COUNT);
 
-        noise->out_white[i] = w;
-        noise->out_red[i] = noise->red_state;
+    float red = noise->red_state;
+    for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
+    {
+        red = a_red * red + b_red * noise->out_white[i];
+        noise->out_red[i] = red;
     }
+    noise->red_state = red;
 }
 
 //
@@ -392,22 +1194,14 @@ void tr_quantizer_update(tr_quantizer_t* quantizer)
 {
     if (quantizer->in_cv == NULL)
     {
-        for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
-        {
-            quantizer->out_cv[i] = 0.0f;
-        }
+        memset(quantizer->out_cv, 0, sizeof(float) * TR_SAMPLE_COUNT);
         return;
     }
 
     switch (quantizer->in_mode)
     {
         case TR_QUANTIZER_CHROMATIC:
-            for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
-            {
-                float cv = quantizer->in_cv[i];
-                cv = tr_floorf(cv * 12.0f) / 12.0f;
-                quantizer->out_cv[i] = cv;
-            }
+            tr_buf_floor_semitone(quantizer->out_cv, quantizer->in_cv);
             break;
         case TR_QUANTIZER_MINOR:
             tr_quantizer_apply_lut(quantizer, tr_quantizer_lut_minor);
@@ -436,12 +1230,184 @@ void tr_quantizer_update(tr_quantizer_t* quantizer)
 
 void tr_random_update(tr_random_t* random)
 {
+    tr_buf s0, s1, s2;
     for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
     {
         random->t0 = tr_fmodf(random->t0 + random->in_speed, TR_TWOPI);
         random->t1 = tr_fmodf(random->t1 + random->in_speed * 3.1534324234f, TR_TWOPI);
         random->t2 = tr_fmodf(random->t2 + random->in_speed * 5.333223f, TR_TWOPI);
 
-        random->out_cv[i] = tr_sinf(random->t0) * tr_sinf(random->t1) * tr_sinf(random->t2);
+        s0[i] = random->t0;
+        s1[i] = random->t1;
+        s2[i] = random->t2;
+    }
+
+    tr_sinf_buf(s0, s0, TR_SAMPLE_COUNT);
+    tr_sinf_buf(s1, s1, TR_SAMPLE_COUNT);
+    tr_sinf_buf(s2, s2, TR_SAMPLE_COUNT);
+
+    for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
+    {
+        random->out_cv[i] = s0[i] * s1[i] * s2[i];
+    }
+}
+
+//
+// tr_wavetable_t
+//
+
+// One table per shape and octave. Level l holds the harmonics up to
+// TR_WAVETABLE_SIZE / 2 >> l, and is used for phase increments up to
+// 2^l / TR_WAVETABLE_SIZE, so the highest harmonic never goes past Nyquist.
+// The extra sample repeats the first one for the interpolation.
+#define TR_WAVETABLE_SIZE   (1024)
+#define TR_WAVETABLE_LEVELS (10)
+#define TR_WAVETABLE_SHAPES (4)
+
+static float g_tr_wavetables[TR_WAVETABLE_SHAPES][TR_WAVETABLE_LEVELS][TR_WAVETABLE_SIZE + 1];
+
+// Amplitude of harmonic h, in the same polarity as the vco outputs
+static float tr_wavetable_harmonic(enum tr_wavetable_shape shape, int h)
+{
+    switch (shape)
+    {
+        case TR_WAVETABLE_SINE:
+            return h == 1 ? 1.0f : 0.0f;
+        case TR_WAVETABLE_TRIANGLE:
+            return (h & 1) ? (float)(8.0 / (TR_PI * TR_PI)) / (float)(h * h) * ((h & 2) ? -1.0f : 1.0f) : 0.0f;
+        case TR_WAVETABLE_SAW:
+            return (float)(-2.0 / TR_PI) / (float)h;
+        case TR_WAVETABLE_SQUARE:
+            return (h & 1) ? (float)(-4.0 / TR_PI) / (float)h : 0.0f;
+    }
+    return 0.0f;
+}
+
+void tr_wavetable_init(void)
+{
+    // sin(h * x) on the table grid is sine[(h * i) % size]
+    static float sine[TR_WAVETABLE_SIZE];
+    for (int i = 0; i < TR_WAVETABLE_SIZE; ++i)
+    {
+        sine[i] = tr_sinf_precise((float)(TR_TWOPI * i / TR_WAVETABLE_SIZE));
+    }
+
+    for (int shape = 0; shape < TR_WAVETABLE_SHAPES; ++shape)
+    {
+        // from the top level down, each level adds the octave of harmonics
+        // the level above it doesn't have
+        float* above = NULL;
+        for (int level = TR_WAVETABLE_LEVELS - 1; level >= 0; --level)
+        {
+            float* table = g_tr_wavetables[shape][level];
+            const int h_first = above ? (TR_WAVETABLE_SIZE / 2 >> (level + 1)) + 1 : 1;
+            const int h_last = TR_WAVETABLE_SIZE / 2 >> level;
+
+            for (int i = 0; i < TR_WAVETABLE_SIZE; ++i)
+            {
+                float v = above ? above[i] : 0.0f;
+                for (int h = h_first; h <= h_last; ++h)
+                {
+                    v += tr_wavetable_harmonic(shape, h) * sine[(h * i) & (TR_WAVETABLE_SIZE - 1)];
+                }
+                table[i] = v;
+            }
+            table[TR_WAVETABLE_SIZE] = table[0];
+
+            above = table;
+        }
+    }
+}
+
+// Smallest level whose harmonics stay under Nyquist for this increment,
+// ceil(log2(dt * size)) read from the float exponent
+static inline int tr_wavetable_level(float dt)
+{
+    union { float f; uint32_t u; } v = { dt * TR_WAVETABLE_SIZE };
+
+    const int level = (int)((v.u >> 23) & 0xFF) - 127 + ((v.u & 0x7FFFFF) != 0);
+    return level < 0 ? 0 : (level > TR_WAVETABLE_LEVELS - 1 ? TR_WAVETABLE_LEVELS - 1 : level);
+}
+
+static inline const float* tr_wavetable_table(const tr_wavetable_t* wt, int level)
+{
+    const unsigned shape = (unsigned)wt->in_shape < TR_WAVETABLE_SHAPES ? (unsigned)wt->in_shape : 0;
+    return g_tr_wavetables[shape][level];
+}
+
+static inline float tr_wavetable_read(const float* table, float phase)
+{
+    const float pos = phase * TR_WAVETABLE_SIZE;
+    const int i = (int)pos;
+    const float frac = pos - (float)i;
+    return table[i] + frac * (table[i + 1] - table[i]);
+}
+
+static inline float tr_wavetable_advance(tr_wavetable_t* wt, float dt)
+{
+    const float phase = wt->phase;
+    wt->phase += dt;
+    wt->phase -= (float)(int)wt->phase;
+    return phase;
+}
+
+// in_voct unplugged or constant for the block, the pitch is in_v0 * mul and
+// one table serves the whole block
+static void tr_wavetable_update_fixed(tr_wavetable_t* wt, float mul)
+{
+    float from, step;
+    if (tr_smooth_pitch(&wt->v0_smooth, wt->in_v0, &from, &step))
+    {
+        for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
+        {
+            const float d = tr_smooth_at(from, step, i) * mul / TR_SAMPLE_RATE;
+            const float* table = tr_wavetable_table(wt, tr_wavetable_level(d));
+            wt->out_audio[i] = tr_wavetable_read(table, tr_wavetable_advance(wt, d));
+        }
+        return;
+    }
+
+    const float dt = wt->in_v0 * mul / TR_SAMPLE_RATE;
+    const float* table = tr_wavetable_table(wt, tr_wavetable_level(dt));
+
+    for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
+    {
+        wt->out_audio[i] = tr_wavetable_read(table, tr_wavetable_advance(wt, dt));
+    }
+}
+
+static void tr_wavetable_update_free(tr_wavetable_t* wt)
+{
+    tr_wavetable_update_fixed(wt, 1.0f);
+}
+
+void tr_wavetable_update(tr_wavetable_t* wt)
+{
+    if (tr_input_is_constant(wt->in_voct))
+    {
+        tr_wavetable_update_fixed(wt, tr_exp2f(wt->in_voct[0]));
+        return;
+    }
+
+    float from, step;
+    tr_smooth_pitch(&wt->v0_smooth, wt->in_v0, &from, &step);
+
+    tr_buf dt;
+    tr_exp2f_buf(dt, wt->in_voct, TR_SAMPLE_COUNT);
+
+    for (size_t i = 0; i < TR_SAMPLE_COUNT; ++i)
+    {
+        const float d = tr_smooth_at(from, step, i) * dt[i] / TR_SAMPLE_RATE;
+        const float* table = tr_wavetable_table(wt, tr_wavetable_level(d));
+        wt->out_audio[i] = tr_wavetable_read(table, tr_wavetable_advance(wt, d));
+    }
+}
+
+tr_module_update_fn tr_wavetable_specialize(const tr_wavetable_t* wt)
+{
+    if (wt->in_voct == NULL)
+    {
+        return (tr_module_update_fn)tr_wavetable_update_free;
     }
+    return (tr_module_update_fn)tr_wavetable_update;
 }
\ No newline at end of file
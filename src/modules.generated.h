@@ -5,6 +5,8 @@
 #include "modules.types.h"
 #include "modules2.h"
 
+struct tr_gui_module;
+
 enum tr_module_type
 {
 	TR_SPEAKER,
@@ -20,8 +22,12 @@ enum tr_module_type
 	TR_ADSR,
 	TR_RANDOM,
 	TR_QUANTIZER,
+	TR_SVF,
+	TR_LADDER,
+	TR_WAVETABLE,
 	TR_MODULE_COUNT
 };
+#define TR_MODULE_OUTPUT_COUNT_MAX 8
 enum
 {
 	TR_SPEAKER_in_audio,
@@ -31,6 +37,11 @@ static const struct tr_module_field_info tr_speaker__fields[] = {
 	[TR_SPEAKER_in_audio] = {TR_MODULE_FIELD_INPUT_BUFFER, offsetof(struct tr_speaker, in_audio), "in_audio", 50, 60, 0.000000, 0.000000, 0.000000, 0, 0},
 };
 typedef struct tr_speaker tr_speaker_t;
+static inline void tr_speaker__init(void* data)
+{
+	struct tr_speaker* module = (struct tr_speaker*)data;
+	(void)module;
+}
 enum
 {
 	TR_SCOPE_in_0,
@@ -40,9 +51,16 @@ static const struct tr_module_field_info tr_scope__fields[] = {
 	[TR_SCOPE_in_0] = {TR_MODULE_FIELD_INPUT_BUFFER, offsetof(struct tr_scope, in_0), "in_0", 20, 210, 0.000000, 0.000000, 0.000000, 0, 0},
 };
 typedef struct tr_scope tr_scope_t;
+void tr_scope_decorate(tr_scope_t* module, struct tr_gui_module* gui_module);
+static inline void tr_scope__init(void* data)
+{
+	struct tr_scope* module = (struct tr_scope*)data;
+	(void)module;
+}
 enum
 {
 	TR_VCO_phase,
+	TR_VCO_v0_smooth,
 	TR_VCO_in_v0,
 	TR_VCO_in_voct,
 	TR_VCO_out_sin,
@@ -52,6 +70,7 @@ enum
 };
 static const struct tr_module_field_info tr_vco__fields[] = {
 	[TR_VCO_phase] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_vco, phase), "phase", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_VCO_v0_smooth] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_vco, v0_smooth), "v0_smooth", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
 	[TR_VCO_in_v0] = {TR_MODULE_FIELD_INPUT_FLOAT, offsetof(struct tr_vco, in_v0), "in_v0", 24, 50, 20.000000, 1000.000000, 0.000000, 0, 0},
 	[TR_VCO_in_voct] = {TR_MODULE_FIELD_INPUT_BUFFER, offsetof(struct tr_vco, in_voct), "in_voct", 20, 80, 0.000000, 0.000000, 0.000000, 0, 0},
 	[TR_VCO_out_sin] = {TR_MODULE_FIELD_BUFFER, offsetof(struct tr_vco, out_sin), "out_sin", 70, 50, 0.000000, 0.000000, 0.000000, 0, 0},
@@ -59,6 +78,14 @@ static const struct tr_module_field_info tr_vco__fields[] = {
 	[TR_VCO_out_saw] = {TR_MODULE_FIELD_BUFFER, offsetof(struct tr_vco, out_saw), "out_saw", 70, 120, 0.000000, 0.000000, 0.000000, 0, 0},
 };
 typedef struct tr_vco tr_vco_t;
+void tr_vco_update(tr_vco_t* module);
+tr_module_update_fn tr_vco_specialize(const tr_vco_t* module);
+static inline void tr_vco__init(void* data)
+{
+	struct tr_vco* module = (struct tr_vco*)data;
+	(void)module;
+	module->in_v0 = 0.000000f;
+}
 enum
 {
 	TR_CLOCK_phase,
@@ -72,6 +99,14 @@ static const struct tr_module_field_info tr_clock__fields[] = {
 	[TR_CLOCK_out_gate] = {TR_MODULE_FIELD_BUFFER, offsetof(struct tr_clock, out_gate), "out_gate", 70, 50, 0.000000, 0.000000, 0.000000, 0, 0},
 };
 typedef struct tr_clock tr_clock_t;
+void tr_clock_update(tr_clock_t* module);
+void tr_clock_decorate(tr_clock_t* module, struct tr_gui_module* gui_module);
+static inline void tr_clock__init(void* data)
+{
+	struct tr_clock* module = (struct tr_clock*)data;
+	(void)module;
+	module->in_hz = 0.000000f;
+}
 enum
 {
 	TR_VCA_in_audio,
@@ -85,10 +120,20 @@ static const struct tr_module_field_info tr_vca__fields[] = {
 	[TR_VCA_out_mix] = {TR_MODULE_FIELD_BUFFER, offsetof(struct tr_vca, out_mix), "out_mix", 84, 50, 0.000000, 0.000000, 0.000000, 0, 0},
 };
 typedef struct tr_vca tr_vca_t;
+void tr_vca_update(tr_vca_t* module);
+static inline void tr_vca__init(void* data)
+{
+	struct tr_vca* module = (struct tr_vca*)data;
+	(void)module;
+}
 enum
 {
 	TR_LP_value,
 	TR_LP_z,
+	TR_LP_cut0_smooth,
+	TR_LP_cut_mul_smooth,
+	TR_LP_cut_last,
+	TR_LP_a_last,
 	TR_LP_in_audio,
 	TR_LP_in_cut,
 	TR_LP_in_cut0,
@@ -99,6 +144,10 @@ enum
 static const struct tr_module_field_info tr_lp__fields[] = {
 	[TR_LP_value] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_lp, value), "value", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
 	[TR_LP_z] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_lp, z), "z", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_LP_cut0_smooth] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_lp, cut0_smooth), "cut0_smooth", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_LP_cut_mul_smooth] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_lp, cut_mul_smooth), "cut_mul_smooth", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_LP_cut_last] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_lp, cut_last), "cut_last", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_LP_a_last] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_lp, a_last), "a_last", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
 	[TR_LP_in_audio] = {TR_MODULE_FIELD_INPUT_BUFFER, offsetof(struct tr_lp, in_audio), "in_audio", 110, 50, 0.000000, 0.000000, 0.000000, 0, 0},
 	[TR_LP_in_cut] = {TR_MODULE_FIELD_INPUT_BUFFER, offsetof(struct tr_lp, in_cut), "in_cut", 150, 50, 0.000000, 0.000000, 0.000000, 0, 0},
 	[TR_LP_in_cut0] = {TR_MODULE_FIELD_INPUT_FLOAT, offsetof(struct tr_lp, in_cut0), "in_cut0", 24, 50, 0.000000, 1.000000, 0.000000, 0, 0},
@@ -106,8 +155,22 @@ static const struct tr_module_field_info tr_lp__fields[] = {
 	[TR_LP_out_audio] = {TR_MODULE_FIELD_BUFFER, offsetof(struct tr_lp, out_audio), "out_audio", 190, 50, 0.000000, 0.000000, 0.000000, 0, 0},
 };
 typedef struct tr_lp tr_lp_t;
+void tr_lp_update(tr_lp_t* module);
+tr_module_update_fn tr_lp_specialize(const tr_lp_t* module);
+static inline void tr_lp__init(void* data)
+{
+	struct tr_lp* module = (struct tr_lp*)data;
+	(void)module;
+	module->in_cut0 = 0.000000f;
+	module->in_cut_mul = 0.000000f;
+}
 enum
 {
+	TR_MIXER_vol0_smooth,
+	TR_MIXER_vol1_smooth,
+	TR_MIXER_vol2_smooth,
+	TR_MIXER_vol3_smooth,
+	TR_MIXER_vol_final_smooth,
 	TR_MIXER_in_0,
 	TR_MIXER_in_1,
 	TR_MIXER_in_2,
@@ -121,6 +184,11 @@ enum
 	TR_MIXER_FIELD_COUNT
 };
 static const struct tr_module_field_info tr_mixer__fields[] = {
+	[TR_MIXER_vol0_smooth] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_mixer, vol0_smooth), "vol0_smooth", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_MIXER_vol1_smooth] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_mixer, vol1_smooth), "vol1_smooth", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_MIXER_vol2_smooth] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_mixer, vol2_smooth), "vol2_smooth", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_MIXER_vol3_smooth] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_mixer, vol3_smooth), "vol3_smooth", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_MIXER_vol_final_smooth] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_mixer, vol_final_smooth), "vol_final_smooth", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
 	[TR_MIXER_in_0] = {TR_MODULE_FIELD_INPUT_BUFFER, offsetof(struct tr_mixer, in_0), "in_0", 24, 85, 0.000000, 0.000000, 0.000000, 0, 0},
 	[TR_MIXER_in_1] = {TR_MODULE_FIELD_INPUT_BUFFER, offsetof(struct tr_mixer, in_1), "in_1", 64, 85, 0.000000, 0.000000, 0.000000, 0, 0},
 	[TR_MIXER_in_2] = {TR_MODULE_FIELD_INPUT_BUFFER, offsetof(struct tr_mixer, in_2), "in_2", 104, 85, 0.000000, 0.000000, 0.000000, 0, 0},
@@ -133,8 +201,20 @@ static const struct tr_module_field_info tr_mixer__fields[] = {
 	[TR_MIXER_out_mix] = {TR_MODULE_FIELD_BUFFER, offsetof(struct tr_mixer, out_mix), "out_mix", 184, 85, 0.000000, 0.000000, 0.000000, 0, 0},
 };
 typedef struct tr_mixer tr_mixer_t;
+void tr_mixer_update(tr_mixer_t* module);
+static inline void tr_mixer__init(void* data)
+{
+	struct tr_mixer* module = (struct tr_mixer*)data;
+	(void)module;
+	module->in_vol0 = 0.000000f;
+	module->in_vol1 = 0.000000f;
+	module->in_vol2 = 0.000000f;
+	module->in_vol3 = 0.000000f;
+	module->in_vol_final = 1.000000f;
+}
 enum
 {
+	TR_NOISE_seed,
 	TR_NOISE_rng,
 	TR_NOISE_red_state,
 	TR_NOISE_out_white,
@@ -142,12 +222,19 @@ enum
 	TR_NOISE_FIELD_COUNT
 };
 static const struct tr_module_field_info tr_noise__fields[] = {
+	[TR_NOISE_seed] = {TR_MODULE_FIELD_INT, offsetof(struct tr_noise, seed), "seed", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
 	[TR_NOISE_rng] = {TR_MODULE_FIELD_INT, offsetof(struct tr_noise, rng), "rng", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
 	[TR_NOISE_red_state] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_noise, red_state), "red_state", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
 	[TR_NOISE_out_white] = {TR_MODULE_FIELD_BUFFER, offsetof(struct tr_noise, out_white), "out_white", 50, 50, 0.000000, 0.000000, 0.000000, 0, 0},
 	[TR_NOISE_out_red] = {TR_MODULE_FIELD_BUFFER, offsetof(struct tr_noise, out_red), "out_red", 50, 85, 0.000000, 0.000000, 0.000000, 0, 0},
 };
 typedef struct tr_noise tr_noise_t;
+void tr_noise_update(tr_noise_t* module);
+static inline void tr_noise__init(void* data)
+{
+	struct tr_noise* module = (struct tr_noise*)data;
+	(void)module;
+}
 enum
 {
 	TR_CLOCKDIV_gate,
@@ -177,6 +264,14 @@ static const struct tr_module_field_info tr_clockdiv__fields[] = {
 	[TR_CLOCKDIV_out_7] = {TR_MODULE_FIELD_BUFFER, offsetof(struct tr_clockdiv, out_7), "out_7", 370, 50, 0.000000, 0.000000, 0.000000, 0, 0},
 };
 typedef struct tr_clockdiv tr_clockdiv_t;
+void tr_clockdiv_update(tr_clockdiv_t* module);
+void tr_clockdiv_decorate(tr_clockdiv_t* module, struct tr_gui_module* gui_module);
+tr_module_update_fn tr_clockdiv_specialize(const tr_clockdiv_t* module);
+static inline void tr_clockdiv__init(void* data)
+{
+	struct tr_clockdiv* module = (struct tr_clockdiv*)data;
+	(void)module;
+}
 enum
 {
 	TR_SEQ8_step,
@@ -208,6 +303,22 @@ static const struct tr_module_field_info tr_seq8__fields[] = {
 	[TR_SEQ8_out_cv] = {TR_MODULE_FIELD_BUFFER, offsetof(struct tr_seq8, out_cv), "out_cv", 370, 50, 0.000000, 0.000000, 0.000000, 0, 0},
 };
 typedef struct tr_seq8 tr_seq8_t;
+void tr_seq8_update(tr_seq8_t* module);
+void tr_seq8_decorate(tr_seq8_t* module, struct tr_gui_module* gui_module);
+tr_module_update_fn tr_seq8_specialize(const tr_seq8_t* module);
+static inline void tr_seq8__init(void* data)
+{
+	struct tr_seq8* module = (struct tr_seq8*)data;
+	(void)module;
+	module->in_cv_0 = 0.000000f;
+	module->in_cv_1 = 0.000000f;
+	module->in_cv_2 = 0.000000f;
+	module->in_cv_3 = 0.000000f;
+	module->in_cv_4 = 0.000000f;
+	module->in_cv_5 = 0.000000f;
+	module->in_cv_6 = 0.000000f;
+	module->in_cv_7 = 0.000000f;
+}
 enum
 {
 	TR_ADSR_value,
@@ -233,6 +344,16 @@ static const struct tr_module_field_info tr_adsr__fields[] = {
 	[TR_ADSR_out_env] = {TR_MODULE_FIELD_BUFFER, offsetof(struct tr_adsr, out_env), "out_env", 60, 80, 0.000000, 0.000000, 0.000000, 0, 0},
 };
 typedef struct tr_adsr tr_adsr_t;
+void tr_adsr_update(tr_adsr_t* module);
+static inline void tr_adsr__init(void* data)
+{
+	struct tr_adsr* module = (struct tr_adsr*)data;
+	(void)module;
+	module->in_attack = 0.001000f;
+	module->in_decay = 0.001000f;
+	module->in_sustain = 0.000000f;
+	module->in_release = 0.001000f;
+}
 enum
 {
 	TR_RANDOM_t0,
@@ -250,6 +371,13 @@ static const struct tr_module_field_info tr_random__fields[] = {
 	[TR_RANDOM_out_cv] = {TR_MODULE_FIELD_BUFFER, offsetof(struct tr_random, out_cv), "out_cv", 80, 50, 0.000000, 0.000000, 0.000000, 0, 0},
 };
 typedef struct tr_random tr_random_t;
+void tr_random_update(tr_random_t* module);
+static inline void tr_random__init(void* data)
+{
+	struct tr_random* module = (struct tr_random*)data;
+	(void)module;
+	module->in_speed = 0.000000f;
+}
 enum
 {
 	TR_QUANTIZER_in_mode,
@@ -263,18 +391,183 @@ static const struct tr_module_field_info tr_quantizer__fields[] = {
 	[TR_QUANTIZER_out_cv] = {TR_MODULE_FIELD_BUFFER, offsetof(struct tr_quantizer, out_cv), "out_cv", 166, 86, 0.000000, 0.000000, 0.000000, 0, 0},
 };
 typedef struct tr_quantizer tr_quantizer_t;
+void tr_quantizer_update(tr_quantizer_t* module);
+void tr_quantizer_decorate(tr_quantizer_t* module, struct tr_gui_module* gui_module);
+static inline void tr_quantizer__init(void* data)
+{
+	struct tr_quantizer* module = (struct tr_quantizer*)data;
+	(void)module;
+}
+enum
+{
+	TR_SVF_ic1eq,
+	TR_SVF_ic2eq,
+	TR_SVF_g_last,
+	TR_SVF_cut0_smooth,
+	TR_SVF_res_smooth,
+	TR_SVF_cut_mul_smooth,
+	TR_SVF_in_cut0,
+	TR_SVF_in_res,
+	TR_SVF_in_cut_mul,
+	TR_SVF_in_audio,
+	TR_SVF_in_cut,
+	TR_SVF_out_lp,
+	TR_SVF_out_bp,
+	TR_SVF_out_hp,
+	TR_SVF_FIELD_COUNT
+};
+static const struct tr_module_field_info tr_svf__fields[] = {
+	[TR_SVF_ic1eq] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_svf, ic1eq), "ic1eq", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_SVF_ic2eq] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_svf, ic2eq), "ic2eq", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_SVF_g_last] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_svf, g_last), "g_last", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_SVF_cut0_smooth] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_svf, cut0_smooth), "cut0_smooth", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_SVF_res_smooth] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_svf, res_smooth), "res_smooth", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_SVF_cut_mul_smooth] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_svf, cut_mul_smooth), "cut_mul_smooth", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_SVF_in_cut0] = {TR_MODULE_FIELD_INPUT_FLOAT, offsetof(struct tr_svf, in_cut0), "in_cut0", 24, 50, 0.000000, 1.000000, 0.500000, 0, 0},
+	[TR_SVF_in_res] = {TR_MODULE_FIELD_INPUT_FLOAT, offsetof(struct tr_svf, in_res), "in_res", 64, 50, 0.000000, 1.000000, 0.000000, 0, 0},
+	[TR_SVF_in_cut_mul] = {TR_MODULE_FIELD_INPUT_FLOAT, offsetof(struct tr_svf, in_cut_mul), "in_cut_mul", 104, 50, 0.000000, 2.000000, 0.000000, 0, 0},
+	[TR_SVF_in_audio] = {TR_MODULE_FIELD_INPUT_BUFFER, offsetof(struct tr_svf, in_audio), "in_audio", 150, 50, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_SVF_in_cut] = {TR_MODULE_FIELD_INPUT_BUFFER, offsetof(struct tr_svf, in_cut), "in_cut", 190, 50, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_SVF_out_lp] = {TR_MODULE_FIELD_BUFFER, offsetof(struct tr_svf, out_lp), "out_lp", 260, 50, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_SVF_out_bp] = {TR_MODULE_FIELD_BUFFER, offsetof(struct tr_svf, out_bp), "out_bp", 260, 85, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_SVF_out_hp] = {TR_MODULE_FIELD_BUFFER, offsetof(struct tr_svf, out_hp), "out_hp", 260, 120, 0.000000, 0.000000, 0.000000, 0, 0},
+};
+typedef struct tr_svf tr_svf_t;
+void tr_svf_update(tr_svf_t* module);
+void tr_svf_update_batch(tr_svf_t** modules, size_t count);
+static inline void tr_svf__init(void* data)
+{
+	struct tr_svf* module = (struct tr_svf*)data;
+	(void)module;
+	module->in_cut0 = 0.500000f;
+	module->in_res = 0.000000f;
+	module->in_cut_mul = 0.000000f;
+}
+enum
+{
+	TR_LADDER_s1,
+	TR_LADDER_s2,
+	TR_LADDER_s3,
+	TR_LADDER_s4,
+	TR_LADDER_g_last,
+	TR_LADDER_cut0_smooth,
+	TR_LADDER_res_smooth,
+	TR_LADDER_cut_mul_smooth,
+	TR_LADDER_in_cut0,
+	TR_LADDER_in_res,
+	TR_LADDER_in_cut_mul,
+	TR_LADDER_in_audio,
+	TR_LADDER_in_cut,
+	TR_LADDER_out_audio,
+	TR_LADDER_FIELD_COUNT
+};
+static const struct tr_module_field_info tr_ladder__fields[] = {
+	[TR_LADDER_s1] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_ladder, s1), "s1", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_LADDER_s2] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_ladder, s2), "s2", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_LADDER_s3] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_ladder, s3), "s3", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_LADDER_s4] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_ladder, s4), "s4", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_LADDER_g_last] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_ladder, g_last), "g_last", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_LADDER_cut0_smooth] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_ladder, cut0_smooth), "cut0_smooth", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_LADDER_res_smooth] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_ladder, res_smooth), "res_smooth", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_LADDER_cut_mul_smooth] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_ladder, cut_mul_smooth), "cut_mul_smooth", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_LADDER_in_cut0] = {TR_MODULE_FIELD_INPUT_FLOAT, offsetof(struct tr_ladder, in_cut0), "in_cut0", 24, 50, 0.000000, 1.000000, 0.500000, 0, 0},
+	[TR_LADDER_in_res] = {TR_MODULE_FIELD_INPUT_FLOAT, offsetof(struct tr_ladder, in_res), "in_res", 64, 50, 0.000000, 1.000000, 0.000000, 0, 0},
+	[TR_LADDER_in_cut_mul] = {TR_MODULE_FIELD_INPUT_FLOAT, offsetof(struct tr_ladder, in_cut_mul), "in_cut_mul", 104, 50, 0.000000, 2.000000, 0.000000, 0, 0},
+	[TR_LADDER_in_audio] = {TR_MODULE_FIELD_INPUT_BUFFER, offsetof(struct tr_ladder, in_audio), "in_audio", 150, 50, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_LADDER_in_cut] = {TR_MODULE_FIELD_INPUT_BUFFER, offsetof(struct tr_ladder, in_cut), "in_cut", 190, 50, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_LADDER_out_audio] = {TR_MODULE_FIELD_BUFFER, offsetof(struct tr_ladder, out_audio), "out_audio", 230, 50, 0.000000, 0.000000, 0.000000, 0, 0},
+};
+typedef struct tr_ladder tr_ladder_t;
+void tr_ladder_update(tr_ladder_t* module);
+void tr_ladder_update_batch(tr_ladder_t** modules, size_t count);
+static inline void tr_ladder__init(void* data)
+{
+	struct tr_ladder* module = (struct tr_ladder*)data;
+	(void)module;
+	module->in_cut0 = 0.500000f;
+	module->in_res = 0.000000f;
+	module->in_cut_mul = 0.000000f;
+}
+enum
+{
+	TR_WAVETABLE_phase,
+	TR_WAVETABLE_v0_smooth,
+	TR_WAVETABLE_in_shape,
+	TR_WAVETABLE_in_v0,
+	TR_WAVETABLE_in_voct,
+	TR_WAVETABLE_out_audio,
+	TR_WAVETABLE_FIELD_COUNT
+};
+static const struct tr_module_field_info tr_wavetable__fields[] = {
+	[TR_WAVETABLE_phase] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_wavetable, phase), "phase", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_WAVETABLE_v0_smooth] = {TR_MODULE_FIELD_FLOAT, offsetof(struct tr_wavetable, v0_smooth), "v0_smooth", 0, 0, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_WAVETABLE_in_shape] = {TR_MODULE_FIELD_INPUT_INT, offsetof(struct tr_wavetable, in_shape), "in_shape", 24, 50, 0.000000, 0.000000, 0.000000, 0, 3},
+	[TR_WAVETABLE_in_v0] = {TR_MODULE_FIELD_INPUT_FLOAT, offsetof(struct tr_wavetable, in_v0), "in_v0", 24, 90, 20.000000, 1000.000000, 0.000000, 0, 0},
+	[TR_WAVETABLE_in_voct] = {TR_MODULE_FIELD_INPUT_BUFFER, offsetof(struct tr_wavetable, in_voct), "in_voct", 20, 125, 0.000000, 0.000000, 0.000000, 0, 0},
+	[TR_WAVETABLE_out_audio] = {TR_MODULE_FIELD_BUFFER, offsetof(struct tr_wavetable, out_audio), "out_audio", 166, 125, 0.000000, 0.000000, 0.000000, 0, 0},
+};
+typedef struct tr_wavetable tr_wavetable_t;
+void tr_wavetable_update(tr_wavetable_t* module);
+void tr_wavetable_decorate(tr_wavetable_t* module, struct tr_gui_module* gui_module);
+tr_module_update_fn tr_wavetable_specialize(const tr_wavetable_t* module);
+static inline void tr_wavetable__init(void* data)
+{
+	struct tr_wavetable* module = (struct tr_wavetable*)data;
+	(void)module;
+	module->in_v0 = 0.000000f;
+}
 static const struct tr_module_info tr_module_infos[] = {
 	[TR_SPEAKER] = {"speaker", sizeof(struct tr_speaker), tr_speaker__fields, 1, 100, 100},
 	[TR_SCOPE] = {"scope", sizeof(struct tr_scope), tr_scope__fields, 1, 200, 220},
-	[TR_VCO] = {"vco", sizeof(struct tr_vco), tr_vco__fields, 6, 100, 160},
+	[TR_VCO] = {"vco", sizeof(struct tr_vco), tr_vco__fields, 7, 100, 160},
 	[TR_CLOCK] = {"clock", sizeof(struct tr_clock), tr_clock__fields, 3, 100, 100},
 	[TR_VCA] = {"vca", sizeof(struct tr_vca), tr_vca__fields, 3, 200, 100},
-	[TR_LP] = {"lp", sizeof(struct tr_lp), tr_lp__fields, 7, 250, 100},
-	[TR_MIXER] = {"mixer", sizeof(struct tr_mixer), tr_mixer__fields, 10, 250, 110},
-	[TR_NOISE] = {"noise", sizeof(struct tr_noise), tr_noise__fields, 4, 100, 120},
+	[TR_LP] = {"lp", sizeof(struct tr_lp), tr_lp__fields, 11, 250, 100},
+	[TR_MIXER] = {"mixer", sizeof(struct tr_mixer), tr_mixer__fields, 15, 250, 110},
+	[TR_NOISE] = {"noise", sizeof(struct tr_noise), tr_noise__fields, 5, 100, 120},
 	[TR_CLOCKDIV] = {"clockdiv", sizeof(struct tr_clockdiv), tr_clockdiv__fields, 11, 400, 100},
 	[TR_SEQ8] = {"seq8", sizeof(struct tr_seq8), tr_seq8__fields, 12, 400, 100},
 	[TR_ADSR] = {"adsr", sizeof(struct tr_adsr), tr_adsr__fields, 9, 200, 100},
 	[TR_RANDOM] = {"random", sizeof(struct tr_random), tr_random__fields, 5, 100, 100},
 	[TR_QUANTIZER] = {"quantizer", sizeof(struct tr_quantizer), tr_quantizer__fields, 3, 190, 110},
-};
\ No newline at end of file
+	[TR_SVF] = {"svf", sizeof(struct tr_svf), tr_svf__fields, 14, 290, 160},
+	[TR_LADDER] = {"ladder", sizeof(struct tr_ladder), tr_ladder__fields, 14, 270, 100},
+	[TR_WAVETABLE] = {"wavetable", sizeof(struct tr_wavetable), tr_wavetable__fields, 6, 190, 160},
+};
+union tr_module_data
+{
+	struct tr_speaker tr_speaker;
+	struct tr_scope tr_scope;
+	struct tr_vco tr_vco;
+	struct tr_clock tr_clock;
+	struct tr_vca tr_vca;
+	struct tr_lp tr_lp;
+	struct tr_mixer tr_mixer;
+	struct tr_noise tr_noise;
+	struct tr_clockdiv tr_clockdiv;
+	struct tr_seq8 tr_seq8;
+	struct tr_adsr tr_adsr;
+	struct tr_random tr_random;
+	struct tr_quantizer tr_quantizer;
+	struct tr_svf tr_svf;
+	struct tr_ladder tr_ladder;
+	struct tr_wavetable tr_wavetable;
+};
+static const struct tr_module_vtable tr_module_vtable[TR_MODULE_COUNT] = {
+	[TR_SPEAKER] = {NULL, NULL, NULL, NULL, tr_speaker__init},
+	[TR_SCOPE] = {NULL, (tr_module_decorate_fn)tr_scope_decorate, NULL, NULL, tr_scope__init},
+	[TR_VCO] = {(tr_module_update_fn)tr_vco_update, NULL, (tr_module_specialize_fn)tr_vco_specialize, NULL, tr_vco__init},
+	[TR_CLOCK] = {(tr_module_update_fn)tr_clock_update, (tr_module_decorate_fn)tr_clock_decorate, NULL, NULL, tr_clock__init},
+	[TR_VCA] = {(tr_module_update_fn)tr_vca_update, NULL, NULL, NULL, tr_vca__init},
+	[TR_LP] = {(tr_module_update_fn)tr_lp_update, NULL, (tr_module_specialize_fn)tr_lp_specialize, NULL, tr_lp__init},
+	[TR_MIXER] = {(tr_module_update_fn)tr_mixer_update, NULL, NULL, NULL, tr_mixer__init},
+	[TR_NOISE] = {(tr_module_update_fn)tr_noise_update, NULL, NULL, NULL, tr_noise__init},
+	[TR_CLOCKDIV] = {(tr_module_update_fn)tr_clockdiv_update, (tr_module_decorate_fn)tr_clockdiv_decorate, (tr_module_specialize_fn)tr_clockdiv_specialize, NULL, tr_clockdiv__init},
+	[TR_SEQ8] = {(tr_module_update_fn)tr_seq8_update, (tr_module_decorate_fn)tr_seq8_decorate, (tr_module_specialize_fn)tr_seq8_specialize, NULL, tr_seq8__init},
+	[TR_ADSR] = {(tr_module_update_fn)tr_adsr_update, NULL, NULL, NULL, tr_adsr__init},
+	[TR_RANDOM] = {(tr_module_update_fn)tr_random_update, NULL, NULL, NULL, tr_random__init},
+	[TR_QUANTIZER] = {(tr_module_update_fn)tr_quantizer_update, (tr_module_decorate_fn)tr_quantizer_decorate, NULL, NULL, tr_quantizer__init},
+	[TR_SVF] = {(tr_module_update_fn)tr_svf_update, NULL, NULL, (tr_module_batch_fn)tr_svf_update_batch, tr_svf__init},
+	[TR_LADDER] = {(tr_module_update_fn)tr_ladder_update, NULL, NULL, (tr_module_batch_fn)tr_ladder_update_batch, tr_ladder__init},
+	[TR_WAVETABLE] = {(tr_module_update_fn)tr_wavetable_update, (tr_module_decorate_fn)tr_wavetable_decorate, (tr_module_specialize_fn)tr_wavetable_specialize, NULL, tr_wavetable__init},
+};
@@ -35,5 +35,28 @@ enum tr_module_field_type
 	TR_MODULE_FIELD_BUFFER,
 };
 
+struct tr_gui_module;
+
+typedef void (*tr_module_update_fn)(void* module);
+typedef void (*tr_module_decorate_fn)(void* module, struct tr_gui_module* gui_module);
+typedef void (*tr_module_init_fn)(void* module);
+// Picks the kernel variant matching which inputs are plugged. Called when the
+// schedule is rebuilt, since the input pointers don't change until then.
+typedef tr_module_update_fn (*tr_module_specialize_fn)(const void* module);
+// Updates up to TR_SCHEDULE_BATCH_WIDTH independent modules of the same type
+// in one call, so their state can be processed side by side in SIMD lanes.
+typedef void (*tr_module_batch_fn)(void** modules, size_t count);
+
+// Generated by modcc from the tr_xxx_update/tr_xxx_decorate/... functions it finds.
+struct tr_module_vtable
+{
+	tr_module_update_fn update; // NULL for sinks (speaker, scope)
+	tr_module_decorate_fn decorate;
+	tr_module_specialize_fn specialize; // NULL when update handles every case
+	tr_module_batch_fn batch; // NULL when the modules are only updated one by one
+	tr_module_init_fn init; // writes the default knob values
+};
+
 typedef struct tr_module_info tr_module_info_t;
-typedef struct tr_module_field_info tr_module_field_info_t;
\ No newline at end of file
+typedef struct tr_module_field_info tr_module_field_info_t;
+typedef struct tr_module_vtable tr_module_vtable_t;
\ No newline at end of file
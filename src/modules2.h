@@ -18,6 +18,7 @@ TR_MODULE(Name="vco", Width=100, Height=160)
 struct tr_vco
 {
     float phase;
+    float v0_smooth; // see tr_smooth
 
     TR_FIELD(X=24, Y=50, Min=20.0, Max=1000.0)
     float in_v0;
@@ -26,13 +27,13 @@ struct tr_vco
     tr_input in_voct;
 
     TR_FIELD(X=70, Y=50)
-    tr_buf out_sin;
+    tr_output out_sin;
 
     TR_FIELD(X=70, Y=85)
-    tr_buf out_sqr;
+    tr_output out_sqr;
     
     TR_FIELD(X=70, Y=120)
-    tr_buf out_saw;
+    tr_output out_saw;
 };
 
 TR_MODULE(Name="clock", Width=100, Height=100)
@@ -44,7 +45,7 @@ struct tr_clock
     float in_hz;
 
     TR_FIELD(X=70, Y=50)
-    tr_buf out_gate;
+    tr_output out_gate;
 };
 
 TR_MODULE(Name="vca", Width=200, Height=100)
@@ -57,7 +58,7 @@ struct tr_vca
     tr_input in_cv;
 
     TR_FIELD(X=84, Y=50)
-    tr_buf out_mix;
+    tr_output out_mix;
 };
 
 TR_MODULE(Name="lp", Width=250, Height=100)
@@ -65,6 +66,11 @@ struct tr_lp
 {
     float value;
     float z;
+    // see tr_smooth
+    float cut0_smooth;
+    float cut_mul_smooth;
+    float cut_last; // cutoff control and coefficient at the end of the last block
+    float a_last;
 
     TR_FIELD(X=110, Y=50)
     tr_input in_audio;
@@ -79,12 +85,19 @@ struct tr_lp
     float in_cut_mul;
 
     TR_FIELD(X=190, Y=50)
-    tr_buf out_audio;
+    tr_output out_audio;
 };
 
 TR_MODULE(Name="mixer", Width=250, Height=110)
 struct tr_mixer
 {
+    // see tr_smooth
+    float vol0_smooth;
+    float vol1_smooth;
+    float vol2_smooth;
+    float vol3_smooth;
+    float vol_final_smooth;
+
     TR_FIELD(X=24, Y=85)
     tr_input in_0;
 
@@ -113,20 +126,21 @@ struct tr_mixer
     float in_vol_final;
 
     TR_FIELD(X=184, Y=85)
-    tr_buf out_mix;
+    tr_output out_mix;
 };
 
 TR_MODULE(Name="noise", Width=100, Height=120)
 struct tr_noise
 {
-    int rng;
+    int seed;
+    int rng; // samples generated so far, the counter fed to the hash
     float red_state;
 
     TR_FIELD(X=50, Y=50)
-    tr_buf out_white;
+    tr_output out_white;
 
     TR_FIELD(X=50, Y=85)
-    tr_buf out_red;
+    tr_output out_red;
 };
 
 TR_MODULE(Name="clockdiv", Width=400, Height=100)
@@ -139,28 +153,28 @@ struct tr_clockdiv
     tr_input in_gate;
 
     TR_FIELD(X=90, Y=50)
-    tr_buf out_0;
+    tr_output out_0;
 
     TR_FIELD(X=130, Y=50)
-    tr_buf out_1;
+    tr_output out_1;
 
     TR_FIELD(X=170, Y=50)
-    tr_buf out_2;
+    tr_output out_2;
 
     TR_FIELD(X=210, Y=50)
-    tr_buf out_3;
+    tr_output out_3;
 
     TR_FIELD(X=250, Y=50)
-    tr_buf out_4;
+    tr_output out_4;
 
     TR_FIELD(X=290, Y=50)
-    tr_buf out_5;
+    tr_output out_5;
 
     TR_FIELD(X=330, Y=50)
-    tr_buf out_6;
+    tr_output out_6;
     
     TR_FIELD(X=370, Y=50)
-    tr_buf out_7;
+    tr_output out_7;
 };
 
 TR_MODULE(Name="seq8", Width=400, Height=100)
@@ -197,7 +211,7 @@ struct tr_seq8
     float in_cv_7;
 
     TR_FIELD(X=370, Y=50)
-    tr_buf out_cv;
+    tr_output out_cv;
 };
 
 TR_MODULE(Name="adsr", Width=200, Height=100)
@@ -223,7 +237,7 @@ struct tr_adsr
     tr_input in_gate;
 
     TR_FIELD(X=60, Y=80)
-    tr_buf out_env;
+    tr_output out_env;
 };
 
 TR_MODULE(Name="random", Width=100, Height=100)
@@ -237,7 +251,7 @@ struct tr_random
     float in_speed;
 
     TR_FIELD(X=80, Y=50)
-    tr_buf out_cv;
+    tr_output out_cv;
 };
 
 enum tr_quantizer_mode
@@ -261,5 +275,103 @@ struct tr_quantizer
     tr_input in_cv;
 
     TR_FIELD(X=166, Y=86)
-    tr_buf out_cv;
+    tr_output out_cv;
+};
+
+// 2-pole state variable filter, batched (see tr_module_batch_fn)
+TR_MODULE(Name="svf", Width=290, Height=160)
+struct tr_svf
+{
+    float ic1eq;
+    float ic2eq;
+    float g_last; // prewarped cutoff at the end of the last block
+    // see tr_smooth
+    float cut0_smooth;
+    float res_smooth;
+    float cut_mul_smooth;
+
+    TR_FIELD(X=24, Y=50, Min=0.0, Max=1.0, Default=0.5)
+    float in_cut0;
+
+    TR_FIELD(X=64, Y=50, Min=0.0, Max=1.0)
+    float in_res;
+
+    TR_FIELD(X=104, Y=50, Min=0.0, Max=2.0)
+    float in_cut_mul;
+
+    TR_FIELD(X=150, Y=50)
+    tr_input in_audio;
+
+    TR_FIELD(X=190, Y=50)
+    tr_input in_cut;
+
+    TR_FIELD(X=260, Y=50)
+    tr_output out_lp;
+
+    TR_FIELD(X=260, Y=85)
+    tr_output out_bp;
+
+    TR_FIELD(X=260, Y=120)
+    tr_output out_hp;
+};
+
+// 4-pole ladder low-pass, batched (see tr_module_batch_fn)
+TR_MODULE(Name="ladder", Width=270, Height=100)
+struct tr_ladder
+{
+    float s1;
+    float s2;
+    float s3;
+    float s4;
+    float g_last; // prewarped cutoff at the end of the last block
+    // see tr_smooth
+    float cut0_smooth;
+    float res_smooth;
+    float cut_mul_smooth;
+
+    TR_FIELD(X=24, Y=50, Min=0.0, Max=1.0, Default=0.5)
+    float in_cut0;
+
+    TR_FIELD(X=64, Y=50, Min=0.0, Max=1.0)
+    float in_res;
+
+    TR_FIELD(X=104, Y=50, Min=0.0, Max=2.0)
+    float in_cut_mul;
+
+    TR_FIELD(X=150, Y=50)
+    tr_input in_audio;
+
+    TR_FIELD(X=190, Y=50)
+    tr_input in_cut;
+
+    TR_FIELD(X=230, Y=50)
+    tr_output out_audio;
+};
+
+enum tr_wavetable_shape
+{
+    TR_WAVETABLE_SINE,
+    TR_WAVETABLE_TRIANGLE,
+    TR_WAVETABLE_SAW,
+    TR_WAVETABLE_SQUARE,
+};
+
+// The tables are shared by every instance, see tr_wavetable_init
+TR_MODULE(Name="wavetable", Width=190, Height=160)
+struct tr_wavetable
+{
+    float phase; // [0..1]
+    float v0_smooth; // see tr_smooth
+
+    TR_FIELD(X=24, Y=50)
+    enum tr_wavetable_shape in_shape;
+
+    TR_FIELD(X=24, Y=90, Min=20.0, Max=1000.0)
+    float in_v0;
+
+    TR_FIELD(X=20, Y=125)
+    tr_input in_voct;
+
+    TR_FIELD(X=166, Y=125)
+    tr_output out_audio;
 };
\ No newline at end of file
@@ -287,6 +287,7 @@ int tr_parse_line(tr_parser_t* p, tr_tokenizer_t* t)
         value->type = TR_SET_VALUE;
         value->module_index = module_index;
         value->field_offset = field_info->offset;
+        value->field_index = (size_t)(field_info - module_info->fields);
         if (field_info->type == TR_MODULE_FIELD_FLOAT ||
             field_info->type == TR_MODULE_FIELD_INPUT_FLOAT)
         {
@@ -378,8 +379,10 @@ int tr_parse_line(tr_parser_t* p, tr_tokenizer_t* t)
             .type = TR_SET_VALUE_BUFFER,
             .module_index = module_index,
             .field_offset = field_info->offset,
+            .field_index = (size_t)(field_info - module_info->fields),
             .target_module_index = tr_token_to_int(t->buf, &module_index_tok),
             .target_field_offset = target_field_info->offset,
+            .target_field_index = (size_t)(target_field_info - target_module_info->fields),
             //.color = {r, g, b, 0xff},
             //.color = tr_random_cable_color(),
         };
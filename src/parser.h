@@ -21,6 +21,7 @@ typedef struct tr_parser_cmd_set_value
 
     size_t module_index;
     size_t field_offset;
+    size_t field_index;
 
     // TR_SET_VALUE
     uint8_t value[8];
@@ -29,6 +30,7 @@ typedef struct tr_parser_cmd_set_value
     // TR_SET_VALUE_BUFFER
     size_t target_module_index;
     size_t target_field_offset;
+    size_t target_field_index;
 } tr_parser_cmd_set_value_t;
 
 typedef struct tr_parser_cmd_connect
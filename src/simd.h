@@ -0,0 +1,279 @@
+#pragma once
+
+#include "types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// 4-wide float vectors for the tr_buf kernels. wasm simd128 (-msimd128),
+// SSE2, NEON, or plain C when none of them is available. Define
+// TR_SIMD_SCALAR to force the plain C version.
+//
+// Buffers don't need to be aligned. TR_SAMPLE_COUNT is a multiple of 4.
+
+#if defined(TR_SIMD_SCALAR)
+#define TR_SIMD_BACKEND_SCALAR
+#elif defined(__wasm_simd128__)
+#define TR_SIMD_BACKEND_WASM
+#include <wasm_simd128.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#define TR_SIMD_BACKEND_SSE
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define TR_SIMD_BACKEND_NEON
+#include <arm_neon.h>
+#else
+#define TR_SIMD_BACKEND_SCALAR
+#endif
+
+_Static_assert(TR_SAMPLE_COUNT % 4 == 0, "tr_buf kernels process 4 samples at a time");
+
+#if defined(TR_SIMD_BACKEND_WASM)
+
+typedef v128_t tr_v4;
+
+static inline tr_v4 tr_v4_load(const float* p) { return wasm_v128_load(p); }
+static inline void tr_v4_store(float* p, tr_v4 a) { wasm_v128_store(p, a); }
+static inline tr_v4 tr_v4_set1(float x) { return wasm_f32x4_splat(x); }
+static inline tr_v4 tr_v4_set(float x, float y, float z, float w) { return wasm_f32x4_make(x, y, z, w); }
+static inline tr_v4 tr_v4_add(tr_v4 a, tr_v4 b) { return wasm_f32x4_add(a, b); }
+static inline tr_v4 tr_v4_sub(tr_v4 a, tr_v4 b) { return wasm_f32x4_sub(a, b); }
+static inline tr_v4 tr_v4_mul(tr_v4 a, tr_v4 b) { return wasm_f32x4_mul(a, b); }
+static inline tr_v4 tr_v4_div(tr_v4 a, tr_v4 b) { return wasm_f32x4_div(a, b); }
+static inline tr_v4 tr_v4_floor(tr_v4 a) { return wasm_f32x4_floor(a); }
+// a > b ? x : y
+static inline tr_v4 tr_v4_select_gt(tr_v4 a, tr_v4 b, tr_v4 x, tr_v4 y) { return wasm_v128_bitselect(x, y, wasm_f32x4_gt(a, b)); }
+// bit k set when a[k] > b[k]
+static inline int tr_v4_mask_gt(tr_v4 a, tr_v4 b) { return (int)wasm_i32x4_bitmask(wasm_f32x4_gt(a, b)); }
+
+// r[j][k] <- r[k][j], turns 4 samples of 4 buffers into 4 lanes of 4 samples
+static inline void tr_v4_transpose(tr_v4 r[4])
+{
+    const tr_v4 t0 = wasm_i32x4_shuffle(r[0], r[1], 0, 4, 1, 5);
+    const tr_v4 t1 = wasm_i32x4_shuffle(r[2], r[3], 0, 4, 1, 5);
+    const tr_v4 t2 = wasm_i32x4_shuffle(r[0], r[1], 2, 6, 3, 7);
+    const tr_v4 t3 = wasm_i32x4_shuffle(r[2], r[3], 2, 6, 3, 7);
+    r[0] = wasm_i32x4_shuffle(t0, t1, 0, 1, 4, 5);
+    r[1] = wasm_i32x4_shuffle(t0, t1, 2, 3, 6, 7);
+    r[2] = wasm_i32x4_shuffle(t2, t3, 0, 1, 4, 5);
+    r[3] = wasm_i32x4_shuffle(t2, t3, 2, 3, 6, 7);
+}
+
+#elif defined(TR_SIMD_BACKEND_SSE)
+
+typedef __m128 tr_v4;
+
+static inline tr_v4 tr_v4_load(const float* p) { return _mm_loadu_ps(p); }
+static inline void tr_v4_store(float* p, tr_v4 a) { _mm_storeu_ps(p, a); }
+static inline tr_v4 tr_v4_set1(float x) { return _mm_set1_ps(x); }
+static inline tr_v4 tr_v4_set(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+static inline tr_v4 tr_v4_add(tr_v4 a, tr_v4 b) { return _mm_add_ps(a, b); }
+static inline tr_v4 tr_v4_sub(tr_v4 a, tr_v4 b) { return _mm_sub_ps(a, b); }
+static inline tr_v4 tr_v4_mul(tr_v4 a, tr_v4 b) { return _mm_mul_ps(a, b); }
+static inline tr_v4 tr_v4_div(tr_v4 a, tr_v4 b) { return _mm_div_ps(a, b); }
+static inline tr_v4 tr_v4_select_gt(tr_v4 a, tr_v4 b, tr_v4 x, tr_v4 y)
+{
+    const __m128 mask = _mm_cmpgt_ps(a, b);
+    return _mm_or_ps(_mm_and_ps(mask, x), _mm_andnot_ps(mask, y));
+}
+static inline int tr_v4_mask_gt(tr_v4 a, tr_v4 b) { return _mm_movemask_ps(_mm_cmpgt_ps(a, b)); }
+
+static inline void tr_v4_transpose(tr_v4 r[4])
+{
+    _MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+}
+
+// SSE2 has no floor, truncate and step down where that rounded up.
+// Fine for |a| < 2^31, which covers every signal in the rack.
+static inline tr_v4 tr_v4_floor(tr_v4 a)
+{
+    const __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+    return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a), _mm_set1_ps(1.0f)));
+}
+
+#elif defined(TR_SIMD_BACKEND_NEON)
+
+typedef float32x4_t tr_v4;
+
+static inline tr_v4 tr_v4_load(const float* p) { return vld1q_f32(p); }
+static inline void tr_v4_store(float* p, tr_v4 a) { vst1q_f32(p, a); }
+static inline tr_v4 tr_v4_set1(float x) { return vdupq_n_f32(x); }
+static inline tr_v4 tr_v4_set(float x, float y, float z, float w) { const float v[4] = {x, y, z, w}; return vld1q_f32(v); }
+static inline tr_v4 tr_v4_add(tr_v4 a, tr_v4 b) { return vaddq_f32(a, b); }
+static inline tr_v4 tr_v4_sub(tr_v4 a, tr_v4 b) { return vsubq_f32(a, b); }
+static inline tr_v4 tr_v4_mul(tr_v4 a, tr_v4 b) { return vmulq_f32(a, b); }
+static inline tr_v4 tr_v4_div(tr_v4 a, tr_v4 b) { return vdivq_f32(a, b); }
+static inline tr_v4 tr_v4_floor(tr_v4 a) { return vrndmq_f32(a); }
+static inline tr_v4 tr_v4_select_gt(tr_v4 a, tr_v4 b, tr_v4 x, tr_v4 y) { return vbslq_f32(vcgtq_f32(a, b), x, y); }
+static inline int tr_v4_mask_gt(tr_v4 a, tr_v4 b)
+{
+    const uint32x4_t bits = {1, 2, 4, 8};
+    return (int)vaddvq_u32(vandq_u32(vcgtq_f32(a, b), bits));
+}
+
+static inline void tr_v4_transpose(tr_v4 r[4])
+{
+    const float64x2_t t0 = vreinterpretq_f64_f32(vzip1q_f32(r[0], r[1]));
+    const float64x2_t t1 = vreinterpretq_f64_f32(vzip1q_f32(r[2], r[3]));
+    const float64x2_t t2 = vreinterpretq_f64_f32(vzip2q_f32(r[0], r[1]));
+    const float64x2_t t3 = vreinterpretq_f64_f32(vzip2q_f32(r[2], r[3]));
+    r[0] = vreinterpretq_f32_f64(vzip1q_f64(t0, t1));
+    r[1] = vreinterpretq_f32_f64(vzip2q_f64(t0, t1));
+    r[2] = vreinterpretq_f32_f64(vzip1q_f64(t2, t3));
+    r[3] = vreinterpretq_f32_f64(vzip2q_f64(t2, t3));
+}
+
+#else
+
+typedef struct tr_v4
+{
+    float x[4];
+} tr_v4;
+
+#define TR_V4_OP(_Expr) tr_v4 r; for (int k = 0; k < 4; ++k) r.x[k] = (_Expr); return r
+
+static inline tr_v4 tr_v4_load(const float* p) { TR_V4_OP(p[k]); }
+static inline void tr_v4_store(float* p, tr_v4 a) { for (int k = 0; k < 4; ++k) p[k] = a.x[k]; }
+static inline tr_v4 tr_v4_set1(float x) { TR_V4_OP(x); }
+static inline tr_v4 tr_v4_set(float x, float y, float z, float w) { return (tr_v4){{x, y, z, w}}; }
+static inline tr_v4 tr_v4_add(tr_v4 a, tr_v4 b) { TR_V4_OP(a.x[k] + b.x[k]); }
+static inline tr_v4 tr_v4_sub(tr_v4 a, tr_v4 b) { TR_V4_OP(a.x[k] - b.x[k]); }
+static inline tr_v4 tr_v4_mul(tr_v4 a, tr_v4 b) { TR_V4_OP(a.x[k] * b.x[k]); }
+static inline tr_v4 tr_v4_div(tr_v4 a, tr_v4 b) { TR_V4_OP(a.x[k] / b.x[k]); }
+static inline tr_v4 tr_v4_floor(tr_v4 a) { TR_V4_OP(__builtin_floorf(a.x[k])); }
+static inline tr_v4 tr_v4_select_gt(tr_v4 a, tr_v4 b, tr_v4 x, tr_v4 y) { TR_V4_OP(a.x[k] > b.x[k] ? x.x[k] : y.x[k]); }
+static inline int tr_v4_mask_gt(tr_v4 a, tr_v4 b)
+{
+    int mask = 0;
+    for (int k = 0; k < 4; ++k) mask |= (a.x[k] > b.x[k]) << k;
+    return mask;
+}
+
+static inline void tr_v4_transpose(tr_v4 r[4])
+{
+    const tr_v4 t[4] = {r[0], r[1], r[2], r[3]};
+    for (int j = 0; j < 4; ++j)
+    {
+        for (int k = 0; k < 4; ++k)
+        {
+            r[j].x[k] = t[k].x[j];
+        }
+    }
+}
+
+#undef TR_V4_OP
+
+#endif
+
+//
+// tr_buf kernels, out may alias any input
+//
+
+// out[begin, end) = v, the run doesn't have to be aligned to 4 samples
+static inline void tr_buf_fill_run(float* out, size_t begin, size_t end, float v)
+{
+    const tr_v4 vv = tr_v4_set1(v);
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4)
+    {
+        tr_v4_store(out + i, vv);
+    }
+    for (; i < end; ++i)
+    {
+        out[i] = v;
+    }
+}
+
+// First index at or after i where (in > 0) stops being high, TR_SAMPLE_COUNT
+// when it holds until the end of the block. Gates and clocks change a few
+// times per block at most, so this tests 4 samples per compare.
+static inline size_t tr_buf_find_gate_edge(const float* in, size_t i, bool high)
+{
+    const int expect = high ? 0xf : 0x0;
+
+    for (; i < TR_SAMPLE_COUNT && (i & 3) != 0; ++i)
+    {
+        if ((in[i] > 0.0f) != high)
+        {
+            return i;
+        }
+    }
+
+    const tr_v4 zero = tr_v4_set1(0.0f);
+    for (; i < TR_SAMPLE_COUNT; i += 4)
+    {
+        const int diff = tr_v4_mask_gt(tr_v4_load(in + i), zero) ^ expect;
+        if (diff != 0)
+        {
+            return i + (size_t)__builtin_ctz((unsigned)diff);
+        }
+    }
+    return TR_SAMPLE_COUNT;
+}
+
+// out = a * b
+static inline void tr_buf_mul(float* out, const float* a, const float* b)
+{
+    for (size_t i = 0; i < TR_SAMPLE_COUNT; i += 4)
+    {
+        tr_v4_store(out + i, tr_v4_mul(tr_v4_load(a + i), tr_v4_load(b + i)));
+    }
+}
+
+// out = in * k
+static inline void tr_buf_scale(float* out, const float* in, float k)
+{
+    const tr_v4 vk = tr_v4_set1(k);
+    for (size_t i = 0; i < TR_SAMPLE_COUNT; i += 4)
+    {
+        tr_v4_store(out + i, tr_v4_mul(tr_v4_load(in + i), vk));
+    }
+}
+
+// out += in * k
+static inline void tr_buf_madd(float* out, const float* in, float k)
+{
+    const tr_v4 vk = tr_v4_set1(k);
+    for (size_t i = 0; i < TR_SAMPLE_COUNT; i += 4)
+    {
+        tr_v4_store(out + i, tr_v4_add(tr_v4_load(out + i), tr_v4_mul(tr_v4_load(in + i), vk)));
+    }
+}
+
+// out += in * (from + step * (i + 1)), a gain ramp (see tr_smooth)
+static inline void tr_buf_madd_ramp(float* out, const float* in, float from, float step)
+{
+    const tr_v4 vstep = tr_v4_set1(step);
+    const tr_v4 vfrom = tr_v4_set1(from);
+    tr_v4 index = tr_v4_set(1.0f, 2.0f, 3.0f, 4.0f);
+    for (size_t i = 0; i < TR_SAMPLE_COUNT; i += 4)
+    {
+        const tr_v4 gain = tr_v4_add(vfrom, tr_v4_mul(vstep, index));
+        tr_v4_store(out + i, tr_v4_add(tr_v4_load(out + i), tr_v4_mul(tr_v4_load(in + i), gain)));
+        index = tr_v4_add(index, tr_v4_set1(4.0f));
+    }
+}
+
+// out = in * (from + step * (i + 1))
+static inline void tr_buf_scale_ramp(float* out, const float* in, float from, float step)
+{
+    const tr_v4 vstep = tr_v4_set1(step);
+    const tr_v4 vfrom = tr_v4_set1(from);
+    tr_v4 index = tr_v4_set(1.0f, 2.0f, 3.0f, 4.0f);
+    for (size_t i = 0; i < TR_SAMPLE_COUNT; i += 4)
+    {
+        const tr_v4 gain = tr_v4_add(vfrom, tr_v4_mul(vstep, index));
+        tr_v4_store(out + i, tr_v4_mul(tr_v4_load(in + i), gain));
+        index = tr_v4_add(index, tr_v4_set1(4.0f));
+    }
+}
+
+// out = floor(in * 12) / 12, 1V/oct snapped down to the semitone
+static inline void tr_buf_floor_semitone(float* out, const float* in)
+{
+    const tr_v4 twelve = tr_v4_set1(12.0f);
+    for (size_t i = 0; i < TR_SAMPLE_COUNT; i += 4)
+    {
+        tr_v4_store(out + i, tr_v4_div(tr_v4_floor(tr_v4_mul(tr_v4_load(in + i), twelve)), twelve));
+    }
+}
@@ -11,6 +11,9 @@
 
 typedef float tr_buf[TR_SAMPLE_COUNT];
 typedef const float* tr_input;
+// Outputs don't own their samples, they point into a pool of buffers shared
+// by the whole rack, see tr_assign_buffers.
+typedef float* tr_output;
 
 typedef struct float2 {
     float x;